@@ -0,0 +1,435 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "alerts.h"
+
+#define RULE_LINE_MAX 1024
+
+static const char *metric_names[] = { "cpu", "mem", "rss", "rss_growth" };
+
+static char* trim(char *s) {
+    while (*s == ' ' || *s == '\t') s++;
+    char *end = s + strlen(s);
+    while (end > s && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r')) end--;
+    *end = '\0';
+    return s;
+}
+
+static int parse_metric(const char *token, AlertMetric *metric) {
+    for (int i = 0; i < (int)(sizeof(metric_names) / sizeof(metric_names[0])); i++) {
+        if (strcmp(token, metric_names[i]) == 0) {
+            *metric = (AlertMetric)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int parse_op(const char *token, AlertOp *op) {
+    if (strcmp(token, ">") == 0) *op = ALERT_GT;
+    else if (strcmp(token, ">=") == 0) *op = ALERT_GE;
+    else if (strcmp(token, "<") == 0) *op = ALERT_LT;
+    else if (strcmp(token, "<=") == 0) *op = ALERT_LE;
+    else return -1;
+    return 0;
+}
+
+/**
+ * @brief Converts a threshold token to the metric's base unit
+ *
+ * Percentages may carry a '%' sign. Sizes default to KB and rates to
+ * KB per second.
+ */
+static int parse_threshold(const char *token, AlertMetric metric, float *threshold) {
+    char *end;
+    double value = strtod(token, &end);
+    if (end == token) return -1;
+
+    if (metric == ALERT_CPU || metric == ALERT_MEM) {
+        if (*end == '%') end++;
+        if (*end != '\0') return -1;
+        *threshold = (float)value;
+        return 0;
+    }
+
+    if (strncasecmp(end, "G", 1) == 0) {
+        value *= 1024.0 * 1024.0;
+        end++;
+    } else if (strncasecmp(end, "M", 1) == 0) {
+        value *= 1024.0;
+        end++;
+    } else if (strncasecmp(end, "K", 1) == 0) {
+        end++;
+    }
+    if (strncasecmp(end, "B", 1) == 0) end++;
+
+    if (metric == ALERT_RSS_GROWTH) {
+        if (strcmp(end, "/min") == 0) {
+            value /= 60.0;
+            end += 4;
+        } else if (strcmp(end, "/h") == 0) {
+            value /= 3600.0;
+            end += 2;
+        } else if (strcmp(end, "/s") == 0) {
+            end += 2;
+        }
+    }
+    if (*end != '\0') return -1;
+
+    *threshold = (float)value;
+    return 0;
+}
+
+// Returns 0 on success, -1 on a syntax error and -2 if the duration is too long
+static int parse_duration(const char *token, int interval, unsigned short *ticks) {
+    char *end;
+    long value = strtol(token, &end, 10);
+    if (end == token || value <= 0) return -1;
+
+    if (*end == 's') {
+        end++;
+        // Round up so "for 30s" never fires earlier than 30 seconds
+        value = (value + interval - 1) / interval;
+    }
+    if (*end != '\0') return -1;
+    if (value > ALERT_MAX_TICKS) return -2;
+
+    *ticks = (unsigned short)value;
+    return 0;
+}
+
+static int compile_rule(char *line, int interval, AlertRule *rule) {
+    memset(rule, 0, sizeof(AlertRule));
+    rule->ticks = 1;
+
+    rule->text = strdup(line);
+    if (!rule->text) return -1;
+
+    char *arrow = strstr(line, "->");
+    if (!arrow) return -1;
+    *arrow = '\0';
+
+    // Condition: <metric> <op> <value> [for <duration>]
+    char *save;
+    char *token = strtok_r(line, " \t", &save);
+    if (!token || parse_metric(token, &rule->metric) == -1) return -1;
+    token = strtok_r(NULL, " \t", &save);
+    if (!token || parse_op(token, &rule->op) == -1) return -1;
+    token = strtok_r(NULL, " \t", &save);
+    if (!token || parse_threshold(token, rule->metric, &rule->threshold) == -1) return -1;
+    token = strtok_r(NULL, " \t", &save);
+    if (token) {
+        if (strcmp(token, "for") != 0) return -1;
+        token = strtok_r(NULL, " \t", &save);
+        if (!token) return -1;
+        int ret = parse_duration(token, interval, &rule->ticks);
+        if (ret != 0) return ret;
+        if (strtok_r(NULL, " \t", &save) != NULL) return -1;
+    }
+
+    // Action: <action> <argument>, where the argument runs to the end of the line
+    char *action = trim(arrow + 2);
+    char *argument = action + strcspn(action, " \t");
+    if (*argument != '\0') *argument++ = '\0';
+    argument = trim(argument);
+    if (*argument == '\0') return -1;
+
+    if (strcmp(action, "log") == 0) {
+        rule->action = ALERT_LOG;
+        rule->log = fopen(argument, "ae");
+        if (rule->log == NULL) {
+            perror("fopen");
+            return -1;
+        }
+    } else if (strcmp(action, "exec") == 0) {
+        rule->action = ALERT_EXEC;
+    } else if (strcmp(action, "snapshot") == 0) {
+        rule->action = ALERT_SNAPSHOT;
+    } else {
+        return -1;
+    }
+
+    rule->argument = strdup(argument);
+    return rule->argument ? 0 : -1;
+}
+
+static void free_rule(AlertRule *rule) {
+    if (rule->log) fclose(rule->log);
+    free(rule->argument);
+    free(rule->text);
+}
+
+/**
+ * @brief Compiles a rule file into an alert engine
+ *
+ * @param path Path to the rule file
+ * @param interval Refresh interval in seconds
+ * @return AlertEngine* Pointer to the compiled engine, NULL if error
+ */
+AlertEngine* compile_alert_rules(const char *path, int interval) {
+    if (!path || interval <= 0) return NULL;
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror("fopen");
+        return NULL;
+    }
+
+    AlertEngine *engine = calloc(1, sizeof(AlertEngine));
+    if (!engine) {
+        fclose(file);
+        return NULL;
+    }
+    engine->rules = calloc(PID_TABLE_MAX_RULES, sizeof(AlertRule));
+    if (!engine->rules) {
+        free(engine);
+        fclose(file);
+        return NULL;
+    }
+
+    char line[RULE_LINE_MAX];
+    int line_num = 0;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line_num++;
+        char *rule_text = trim(line);
+        if (*rule_text == '\0' || *rule_text == '#') continue;
+
+        if (engine->num_rules == PID_TABLE_MAX_RULES) {
+            fprintf(stderr, "%s:%d: too many rules (maximum %d)\n", path, line_num, PID_TABLE_MAX_RULES);
+            cleanup_alert_rules(engine);
+            fclose(file);
+            return NULL;
+        }
+
+        AlertRule *rule = &engine->rules[engine->num_rules];
+        int ret = compile_rule(rule_text, interval, rule);
+        if (ret != 0) {
+            if (ret == -2) {
+                fprintf(stderr, "%s:%d: duration exceeds %d ticks at a %ds interval\n",
+                        path, line_num, ALERT_MAX_TICKS, interval);
+            } else {
+                fprintf(stderr, "%s:%d: invalid rule\n", path, line_num);
+            }
+            free_rule(rule);
+            cleanup_alert_rules(engine);
+            fclose(file);
+            return NULL;
+        }
+        engine->num_rules++;
+    }
+
+    if (fclose(file) == EOF) {
+        perror("fclose");
+    }
+
+    return engine;
+}
+
+static int rule_matches(const AlertRule *rule, float value) {
+    switch (rule->op) {
+        case ALERT_GT: return value > rule->threshold;
+        case ALERT_GE: return value >= rule->threshold;
+        case ALERT_LT: return value < rule->threshold;
+        case ALERT_LE: return value <= rule->threshold;
+    }
+    return 0;
+}
+
+static void format_timestamp(char *buf, size_t size, time_t now, const char *format) {
+    struct tm tm;
+    localtime_r(&now, &tm);
+    strftime(buf, size, format, &tm);
+}
+
+static void log_event(const AlertRule *rule, const ProcData *proc, float value, const char *event) {
+    char timestamp[32];
+    format_timestamp(timestamp, sizeof(timestamp), time(NULL), "%Y-%m-%d %H:%M:%S");
+    fprintf(rule->log, "%s %s: %s: pid %ld (%s) %s=%.2f\n",
+            timestamp, event, rule->text, proc->pid, proc->name, metric_names[rule->metric], value);
+}
+
+/**
+ * @brief Runs the rule's command without blocking the sampling loop
+ *
+ * The intermediate child exits immediately so the command is reparented
+ * to init and never needs to be reaped here.
+ */
+static void run_command(const AlertRule *rule, const ProcData *proc, float value) {
+    pid_t child = fork();
+    if (child == -1) {
+        perror("fork");
+        return;
+    }
+
+    if (child == 0) {
+        if (fork() == 0) {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%ld", proc->pid);
+            setenv("ALERT_PID", buf, 1);
+            snprintf(buf, sizeof(buf), "%.2f", value);
+            setenv("ALERT_VALUE", buf, 1);
+            setenv("ALERT_NAME", proc->name, 1);
+            setenv("ALERT_RULE", rule->text, 1);
+
+            // Keep the command's output off the monitor's screen
+            int devnull = open("/dev/null", O_RDWR);
+            if (devnull != -1) {
+                dup2(devnull, STDIN_FILENO);
+                dup2(devnull, STDOUT_FILENO);
+                dup2(devnull, STDERR_FILENO);
+                if (devnull > STDERR_FILENO) close(devnull);
+            }
+
+            // The display blocks SIGINT, SIGTERM and friends to read them
+            // from a signalfd; exec would pass that mask on to the command
+            sigset_t empty;
+            sigemptyset(&empty);
+            sigprocmask(SIG_SETMASK, &empty, NULL);
+
+            execl("/bin/sh", "sh", "-c", rule->argument, (char *)NULL);
+            _exit(127);
+        }
+        _exit(0);
+    }
+
+    waitpid(child, NULL, 0);
+}
+
+static void write_snapshot(const AlertRule *rule, int rule_index, const ProcData *proc_data, int len) {
+    time_t now = time(NULL);
+    char timestamp[32];
+    format_timestamp(timestamp, sizeof(timestamp), now, "%Y%m%d-%H%M%S");
+
+    char path[FILENAME_MAX];
+    if (snprintf(path, sizeof(path), "%s/alert-%s-rule%d.txt", rule->argument, timestamp, rule_index) < 0) {
+        perror("snprintf");
+        return;
+    }
+
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        perror("fopen");
+        return;
+    }
+
+    fprintf(file, "# %s\n", rule->text);
+    fprintf(file, "%-10s %-20s %-13s %-10s %-10s %-12s %-10s %-10s\n",
+            "PID", "Name", "State", "%CPU", "%MEM", "Memory (KB)", "Priority", "Nice");
+    for (int i = 0; i < len; i++) {
+        fprintf(file, "%-10ld %-20s %-13s %-10.2f %-10.2f %-12ld %-10d %-10d\n",
+                proc_data[i].pid, proc_data[i].name, proc_data[i].state,
+                proc_data[i].percent_cpu, proc_data[i].percent_mem,
+                proc_data[i].memory_size, proc_data[i].priority, proc_data[i].nice);
+    }
+
+    if (fclose(file) == EOF) {
+        perror("fclose");
+    }
+}
+
+static void fire(AlertEngine *engine, int rule_index, const ProcData *proc, float value) {
+    AlertRule *rule = &engine->rules[rule_index];
+    switch (rule->action) {
+        case ALERT_LOG:
+            log_event(rule, proc, value, "FIRED");
+            break;
+        case ALERT_EXEC:
+            run_command(rule, proc, value);
+            break;
+        case ALERT_SNAPSHOT:
+            // One snapshot per rule per tick, however many processes match
+            engine->pending_snapshots |= 1u << rule_index;
+            break;
+    }
+}
+
+/**
+ * @brief Evaluates every rule against one sample
+ *
+ * @param engine Compiled rules
+ * @param proc_data Array of process data structures
+ * @param len Number of processes in array
+ * @param table PID table holding per-process alert state
+ */
+void evaluate_alerts(AlertEngine *engine, const ProcData *proc_data, int len, PidTable *table) {
+    if (!engine || !proc_data || !table || engine->num_rules == 0) return;
+
+    struct timeval now;
+    get_metrics_time(&now);
+    double elapsed = (now.tv_sec - engine->last_eval.tv_sec) +
+                     (now.tv_usec - engine->last_eval.tv_usec) / 1000000.0;
+    engine->last_eval = now;
+    engine->tick++;
+    engine->pending_snapshots = 0;
+
+    for (int i = 0; i < len; i++) {
+        const ProcData *proc = &proc_data[i];
+        PidEntry *entry = pid_table_find(table, proc->pid);
+        if (!entry) continue;
+
+        // The growth rate is only known if the process was sampled last tick too
+        int have_rate = entry->alert_tick != 0 && entry->alert_tick == engine->tick - 1 && elapsed > 0.0;
+        float rss_rate = have_rate ? (float)((proc->memory_size - entry->prev_rss) / elapsed) : 0.0f;
+        entry->prev_rss = proc->memory_size;
+        entry->alert_tick = engine->tick;
+
+        for (int r = 0; r < engine->num_rules; r++) {
+            const AlertRule *rule = &engine->rules[r];
+            unsigned int bit = 1u << r;
+
+            float value;
+            switch (rule->metric) {
+                case ALERT_CPU: value = proc->percent_cpu; break;
+                case ALERT_MEM: value = proc->percent_mem; break;
+                case ALERT_RSS: value = (float)proc->memory_size; break;
+                default: value = rss_rate; break;
+            }
+            int match = (rule->metric != ALERT_RSS_GROWTH || have_rate) && rule_matches(rule, value);
+
+            if (match) {
+                if (entry->alert_streak[r] < ALERT_MAX_TICKS) entry->alert_streak[r]++;
+                if (entry->alert_streak[r] >= rule->ticks && !(entry->alert_active & bit)) {
+                    entry->alert_active |= bit;
+                    fire(engine, r, proc, value);
+                }
+            } else {
+                if ((entry->alert_active & bit) && rule->action == ALERT_LOG) {
+                    log_event(rule, proc, value, "CLEARED");
+                }
+                entry->alert_active &= ~bit;
+                entry->alert_streak[r] = 0;
+            }
+        }
+    }
+
+    for (int r = 0; r < engine->num_rules; r++) {
+        if (engine->pending_snapshots & (1u << r)) {
+            write_snapshot(&engine->rules[r], r, proc_data, len);
+        }
+        if (engine->rules[r].log) {
+            fflush(engine->rules[r].log);
+        }
+    }
+}
+
+/**
+ * @brief Frees memory allocated for compiled alert rules
+ *
+ * @param engine Pointer to the alert engine
+ */
+void cleanup_alert_rules(AlertEngine *engine) {
+    if (!engine) return;
+
+    for (int i = 0; i < engine->num_rules; i++) {
+        free_rule(&engine->rules[i]);
+    }
+    free(engine->rules);
+    free(engine);
+}
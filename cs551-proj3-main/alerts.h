@@ -0,0 +1,112 @@
+#ifndef ALERTS_H
+#define ALERTS_H
+
+#include <stdio.h>
+#include <sys/time.h>
+#include "proc_data.h"
+#include "proc_metrics.h"
+#include "pid_table.h"
+
+/** Longest duration a rule can require, in ticks */
+#define ALERT_MAX_TICKS PID_TABLE_MAX_STREAK
+
+/**
+ * @brief Per-process quantity a rule compares against its threshold
+ */
+typedef enum {
+    ALERT_CPU,        /**< %CPU */
+    ALERT_MEM,        /**< %MEM */
+    ALERT_RSS,        /**< Resident set size in KB */
+    ALERT_RSS_GROWTH  /**< RSS growth rate in KB per second */
+} AlertMetric;
+
+typedef enum {
+    ALERT_GT,
+    ALERT_GE,
+    ALERT_LT,
+    ALERT_LE
+} AlertOp;
+
+typedef enum {
+    ALERT_LOG,      /**< Append a line to a log file */
+    ALERT_EXEC,     /**< Run a shell command in the background */
+    ALERT_SNAPSHOT  /**< Write every process in the current sample to a file */
+} AlertAction;
+
+/**
+ * @struct AlertRule
+ * @brief A compiled rule
+ *
+ * Rules are written one per line as
+ *
+ *     <metric> <op> <value> [for <duration>] -> <action> <argument>
+ *
+ * for example
+ *
+ *     rss_growth > 100MB/min for 3 -> log /tmp/alerts.log
+ *     cpu > 95 for 30s -> exec logger "pid $ALERT_PID is spinning"
+ *     mem >= 50% -> snapshot /tmp
+ *
+ * Metrics are cpu, mem, rss and rss_growth. Sizes accept K, M and G
+ * suffixes and rates accept /s, /min and /h. A duration is a tick count,
+ * or seconds with an s suffix, and is converted to ticks at compile time.
+ */
+typedef struct {
+    AlertMetric metric;
+    AlertOp op;
+    float threshold;        /**< In the metric's base unit */
+    unsigned short ticks;   /**< Consecutive matching ticks needed to fire */
+    AlertAction action;
+    char *argument;         /**< Log file, command or snapshot directory */
+    FILE *log;              /**< Open log file for ALERT_LOG */
+    char *text;             /**< Original rule text for messages */
+} AlertRule;
+
+/**
+ * @struct AlertEngine
+ * @brief Compiled rule set plus the state shared by all processes
+ */
+typedef struct {
+    AlertRule *rules;
+    int num_rules;
+    unsigned int tick;           /**< Number of evaluations so far */
+    struct timeval last_eval;    /**< Time of the previous evaluation */
+    unsigned int pending_snapshots; /**< Bitmask of snapshot rules fired this tick */
+} AlertEngine;
+
+/**
+ * @brief Compiles a rule file
+ *
+ * Blank lines and lines starting with '#' are ignored. Errors are reported
+ * on stderr with the offending line number.
+ *
+ * @param path Path to the rule file
+ * @param interval Refresh interval in seconds, used to convert durations to ticks
+ * @return Pointer to the compiled engine, or NULL on a parse or I/O error
+ */
+AlertEngine* compile_alert_rules(const char *path, int interval);
+
+/**
+ * @brief Evaluates every rule against one sample
+ *
+ * Must be called once per tick, after update_process_metrics(). Rules are
+ * checked in a single pass over the sample; consecutive-match counts and
+ * firing state live in the PID table entries. A rule fires once when its
+ * count reaches the required number of ticks and re-arms only after the
+ * condition has been false for a tick.
+ *
+ * @param engine Compiled rules
+ * @param proc_data Current sample
+ * @param len Number of processes in the sample
+ * @param table PID table the sample was last updated with
+ */
+void evaluate_alerts(AlertEngine *engine, const ProcData *proc_data, int len, PidTable *table);
+
+/**
+ * @brief Frees an engine returned by compile_alert_rules()
+ *
+ * @param engine Pointer to the engine to free (may be NULL)
+ */
+void cleanup_alert_rules(AlertEngine *engine);
+
+#endif /* ALERTS_H */
@@ -0,0 +1,445 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include "proc_data.h"
+#include "proc_metrics.h"
+#include "cgroup.h"
+
+#define CGROUP_SMALL_FILE 256
+
+static int build_path(const CgroupSet *set, const char *rel, const char *file, char *path, size_t size) {
+    int n = snprintf(path, size, "%s%s%s%s", set->mount, strcmp(rel, "/") == 0 ? "" : rel,
+                     file ? "/" : "", file ? file : "");
+    return (n < 0 || (size_t)n >= size) ? -1 : 0;
+}
+
+static int read_small_file(const CgroupSet *set, const char *rel, const char *file, char *buf) {
+    char path[FILENAME_MAX];
+    if (build_path(set, rel, file, path, sizeof(path)) == -1) return -1;
+    return read_proc_file(path, buf, CGROUP_SMALL_FILE) < 0 ? -1 : 0;
+}
+
+/**
+ * @brief Reads a file of unknown size into the set's procs_buf
+ *
+ * @return Number of bytes read, or -1 on error
+ */
+static ssize_t read_large_file(CgroupSet *set, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return -1;
+
+    size_t len = 0;
+    for (;;) {
+        if (set->procs_buf_size - len < 2) {
+            size_t size = set->procs_buf_size ? set->procs_buf_size * 2 : 4096;
+            char *buf = realloc(set->procs_buf, size);
+            if (!buf) {
+                close(fd);
+                return -1;
+            }
+            set->procs_buf = buf;
+            set->procs_buf_size = size;
+        }
+
+        ssize_t n = read(fd, set->procs_buf + len, set->procs_buf_size - len - 1);
+        if (n < 0) {
+            close(fd);
+            return -1;
+        }
+        if (n == 0) break;
+        len += n;
+    }
+    close(fd);
+    set->procs_buf[len] = '\0';
+
+    return len;
+}
+
+/**
+ * @brief Parses cpu.max ("max 100000" or "<quota> <period>") into cores
+ *
+ * @return Quota in cores, or 0 when the cgroup sets no limit
+ */
+static double read_cpu_max(const CgroupSet *set, const char *rel) {
+    char buf[CGROUP_SMALL_FILE];
+    if (read_small_file(set, rel, "cpu.max", buf) == -1 || strncmp(buf, "max", 3) == 0) {
+        return 0.0;
+    }
+
+    char *p;
+    double quota = strtod(buf, &p);
+    double period = strtod(p, NULL);
+    return (quota > 0.0 && period > 0.0) ? quota / period : 0.0;
+}
+
+/**
+ * @brief Reads a single-number file such as memory.max
+ *
+ * @return 0 on success, -1 when the file is missing or says "max"
+ */
+static int read_u64(const CgroupSet *set, const char *rel, const char *file, unsigned long long *value) {
+    char buf[CGROUP_SMALL_FILE];
+    if (read_small_file(set, rel, file, buf) == -1 || strncmp(buf, "max", 3) == 0) {
+        return -1;
+    }
+    *value = strtoull(buf, NULL, 10);
+    return 0;
+}
+
+static unsigned long long read_usage_usec(const CgroupSet *set, const char *rel) {
+    char buf[CGROUP_SMALL_FILE];
+    if (read_small_file(set, rel, "cpu.stat", buf) == -1) return 0;
+
+    // usage_usec is the first line
+    if (strncmp(buf, "usage_usec ", 11) != 0) return 0;
+    return strtoull(buf + 11, NULL, 10);
+}
+
+static Cgroup* find_previous(Cgroup *prev, int num_prev, int hint, const char *rel) {
+    // Directory order rarely changes, so the group usually sits at the same index
+    if (hint < num_prev && prev[hint].path && strcmp(prev[hint].path, rel) == 0) {
+        return &prev[hint];
+    }
+    for (int i = 0; i < num_prev; i++) {
+        if (prev[i].path && strcmp(prev[i].path, rel) == 0) {
+            return &prev[i];
+        }
+    }
+    return NULL;
+}
+
+static int add_members(CgroupSet *set, const char *rel, int group) {
+    char path[FILENAME_MAX];
+    if (build_path(set, rel, "cgroup.procs", path, sizeof(path)) == -1) return -1;
+    if (read_large_file(set, path) < 0) return -1;
+
+    char *p = set->procs_buf;
+    while (*p != '\0') {
+        char *end;
+        long pid = strtol(p, &end, 10);
+        if (end == p) break;
+        p = end;
+
+        if (set->num_pids == set->members_capacity) {
+            int capacity = set->members_capacity ? set->members_capacity * 2 : 256;
+            CgroupMember *grown = realloc(set->members, capacity * sizeof(CgroupMember));
+            if (!grown) return -1;
+            set->members = grown;
+            set->members_capacity = capacity;
+        }
+        set->members[set->num_pids].pid = pid;
+        set->members[set->num_pids].group = group;
+        set->num_pids++;
+    }
+    return 0;
+}
+
+static int walk(CgroupSet *set, Cgroup *prev, int num_prev, const char *rel,
+                double cpu_limit, unsigned long long memory_limit, long elapsed_us) {
+    if (set->num_groups == set->group_capacity) {
+        int capacity = set->group_capacity ? set->group_capacity * 2 : 16;
+        Cgroup *grown = realloc(set->groups, capacity * sizeof(Cgroup));
+        if (!grown) return -1;
+        set->groups = grown;
+        set->group_capacity = capacity;
+    }
+
+    int index = set->num_groups;
+    Cgroup *group = &set->groups[index];
+    memset(group, 0, sizeof(Cgroup));
+
+    double quota = read_cpu_max(set, rel);
+    group->cpu_limit = (quota > 0.0 && quota < cpu_limit) ? quota : cpu_limit;
+
+    unsigned long long value;
+    group->memory_limit = (read_u64(set, rel, "memory.max", &value) == 0 && value < memory_limit) ? value : memory_limit;
+    if (read_u64(set, rel, "memory.current", &value) == 0) {
+        group->memory_current = value;
+        group->percent_mem = (float)((double)value * 100.0 / (double)group->memory_limit);
+    }
+
+    group->usage_usec = read_usage_usec(set, rel);
+
+    Cgroup *old = find_previous(prev, num_prev, index, rel);
+    if (old) {
+        // Take over the path string and diff against the previous reading
+        group->path = old->path;
+        old->path = NULL;
+        if (elapsed_us > 0 && group->usage_usec >= old->usage_usec) {
+            group->cpu_cores = (double)(group->usage_usec - old->usage_usec) / (double)elapsed_us;
+            group->percent_cpu = (float)(group->cpu_cores * 100.0 / group->cpu_limit);
+        }
+    } else {
+        group->path = strdup(rel);
+        if (!group->path) return -1;
+    }
+    set->num_groups++;
+
+    // A cgroup removed between readdir and here simply has no members
+    add_members(set, rel, index);
+
+    char dir_path[FILENAME_MAX];
+    if (build_path(set, rel, NULL, dir_path, sizeof(dir_path)) == -1) return 0;
+    DIR *dir = opendir(dir_path);
+    if (dir == NULL) return 0;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        if (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN) continue;
+
+        char child[FILENAME_MAX];
+        int n = snprintf(child, sizeof(child), "%s/%s", strcmp(rel, "/") == 0 ? "" : rel, entry->d_name);
+        if (n < 0 || (size_t)n >= sizeof(child)) continue;
+
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            char child_path[FILENAME_MAX];
+            if (build_path(set, child, NULL, child_path, sizeof(child_path)) == -1 ||
+                stat(child_path, &st) == -1 || !S_ISDIR(st.st_mode)) {
+                continue;
+            }
+        }
+
+        // Indices shift as the array grows, so pass limits by value
+        if (walk(set, prev, num_prev, child, set->groups[index].cpu_limit,
+                 set->groups[index].memory_limit, elapsed_us) == -1) {
+            closedir(dir);
+            return -1;
+        }
+    }
+    closedir(dir);
+
+    return 0;
+}
+
+/**
+ * @brief Applies the limits of every ancestor of the monitored root
+ */
+static void inherited_limits(const CgroupSet *set, double *cpu_limit, unsigned long long *memory_limit) {
+    char rel[FILENAME_MAX];
+    snprintf(rel, sizeof(rel), "%s", set->root);
+
+    // Walk up from the root's parent to the top of the hierarchy
+    for (char *slash = strrchr(rel, '/'); slash != NULL && slash != rel; slash = strrchr(rel, '/')) {
+        *slash = '\0';
+        double quota = read_cpu_max(set, rel);
+        if (quota > 0.0 && quota < *cpu_limit) *cpu_limit = quota;
+
+        unsigned long long value;
+        if (read_u64(set, rel, "memory.max", &value) == 0 && value < *memory_limit) *memory_limit = value;
+    }
+}
+
+static int compare_members(const void *a, const void *b) {
+    const CgroupMember *member_a = (const CgroupMember *)a;
+    const CgroupMember *member_b = (const CgroupMember *)b;
+    return (member_a->pid > member_b->pid) - (member_b->pid > member_a->pid);
+}
+
+static int find_mount(char *mount, size_t size) {
+    static const char *candidates[] = { "/sys/fs/cgroup", "/sys/fs/cgroup/unified" };
+
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+        char path[FILENAME_MAX];
+        snprintf(path, sizeof(path), "%s/cgroup.controllers", candidates[i]);
+        if (access(path, R_OK) == 0) {
+            snprintf(mount, size, "%s", candidates[i]);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Sets up cgroup v2 monitoring for a subtree
+ *
+ * @param mount cgroup2 mount point, NULL to detect it
+ * @param subtree Subtree relative to the mount, NULL or "/" for everything
+ * @return CgroupSet* Pointer to the new set, NULL if error
+ */
+CgroupSet* init_cgroups(const char *mount, const char *subtree) {
+    CgroupSet *set = calloc(1, sizeof(CgroupSet));
+    if (!set) return NULL;
+
+    if (mount) {
+        snprintf(set->mount, sizeof(set->mount), "%s", mount);
+    } else if (find_mount(set->mount, sizeof(set->mount)) == -1) {
+        fprintf(stderr, "No cgroup v2 hierarchy found\n");
+        free(set);
+        return NULL;
+    }
+
+    // Normalise to a leading slash and no trailing slash
+    char root[FILENAME_MAX];
+    const char *rel = subtree ? subtree : "/";
+    while (*rel == '/') rel++;
+    snprintf(root, sizeof(root), "/%s", rel);
+    size_t len = strlen(root);
+    while (len > 1 && root[len - 1] == '/') root[--len] = '\0';
+
+    set->root = strdup(root);
+    if (!set->root) {
+        free(set);
+        return NULL;
+    }
+    set->subtree_only = strcmp(set->root, "/") != 0;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    long pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    set->num_cpus = cpus > 0 ? (double)cpus : 1.0;
+    set->total_memory = (pages > 0 && page_size > 0) ? (unsigned long long)pages * page_size : 1;
+
+    char path[FILENAME_MAX];
+    if (build_path(set, set->root, "cgroup.procs", path, sizeof(path)) == -1 || access(path, R_OK) == -1) {
+        fprintf(stderr, "Cannot read cgroup %s under %s\n", set->root, set->mount);
+        cleanup_cgroups(set);
+        return NULL;
+    }
+
+    return set;
+}
+
+/**
+ * @brief Re-reads usage, limits and membership of every monitored cgroup
+ *
+ * @param set Cgroup set
+ * @return int 0 on success, -1 if error
+ */
+int update_cgroups(CgroupSet *set) {
+    if (!set) return -1;
+
+    struct timeval now;
+    get_metrics_time(&now);
+    long elapsed_us = set->last_update.tv_sec == 0 ? 0 :
+                      (now.tv_sec - set->last_update.tv_sec) * 1000000 +
+                      (now.tv_usec - set->last_update.tv_usec);
+    set->last_update = now;
+
+    // The previous tick's groups are kept only to diff usage_usec against
+    Cgroup *prev = set->groups;
+    int num_prev = set->num_groups;
+    set->groups = NULL;
+    set->num_groups = 0;
+    set->group_capacity = 0;
+    set->num_pids = 0;
+
+    double cpu_limit = set->num_cpus;
+    unsigned long long memory_limit = set->total_memory;
+    inherited_limits(set, &cpu_limit, &memory_limit);
+
+    int ret = walk(set, prev, num_prev, set->root, cpu_limit, memory_limit, elapsed_us);
+
+    for (int i = 0; i < num_prev; i++) {
+        free(prev[i].path);
+    }
+    free(prev);
+
+    if (ret == -1 || set->num_groups == 0) return -1;
+
+    qsort(set->members, set->num_pids, sizeof(CgroupMember), compare_members);
+
+    if (set->num_pids > set->pid_capacity) {
+        long *pids = realloc(set->pids, set->num_pids * sizeof(long));
+        if (!pids) return -1;
+        set->pids = pids;
+        int *groups = realloc(set->pid_groups, set->num_pids * sizeof(int));
+        if (!groups) return -1;
+        set->pid_groups = groups;
+        set->pid_capacity = set->num_pids;
+    }
+    for (int i = 0; i < set->num_pids; i++) {
+        set->pids[i] = set->members[i].pid;
+        set->pid_groups[i] = set->members[i].group;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Refreshes the cgroups and scans their processes
+ *
+ * @param set Cgroup set
+ * @param proc_data Receives the process array
+ * @param capacity_hint Expected number of processes, 0 if unknown
+ * @return int Number of processes, -1 if error
+ */
+int get_cgroup_proc_data(CgroupSet *set, ProcData **proc_data, int capacity_hint) {
+    if (update_cgroups(set) == -1) {
+        *proc_data = NULL;
+        return -1;
+    }
+
+    if (set->subtree_only) {
+        return get_proc_data_pids(proc_data, set->pids, set->num_pids);
+    }
+    return get_proc_data(proc_data, capacity_hint);
+}
+
+static int find_group(const CgroupSet *set, long pid) {
+    int lo = 0, hi = set->num_pids - 1;
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (set->pids[mid] == pid) return set->pid_groups[mid];
+        if (set->pids[mid] < pid) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return -1;
+}
+
+/**
+ * @brief Attributes processes to cgroups and makes their percentages cgroup-relative
+ *
+ * @param set Cgroup set
+ * @param proc_data Array of process data structures
+ * @param len Number of processes in array
+ */
+void apply_cgroup_limits(CgroupSet *set, ProcData *proc_data, int len) {
+    if (!set || !proc_data) return;
+
+    for (int g = 0; g < set->num_groups; g++) {
+        set->groups[g].num_procs = 0;
+    }
+
+    for (int i = 0; i < len; i++) {
+        ProcData *proc = &proc_data[i];
+        proc->cgroup = find_group(set, proc->pid);
+        if (proc->cgroup < 0) continue;
+
+        Cgroup *group = &set->groups[proc->cgroup];
+        group->num_procs++;
+
+        // percent_cpu is relative to all online CPUs; rescale to the quota
+        float cpu = (float)(proc->percent_cpu * set->num_cpus / group->cpu_limit);
+        proc->percent_cpu = cpu > 100.0f ? 100.0f : cpu;
+
+        float mem = (float)((double)proc->memory_size * 1024.0 * 100.0 / (double)group->memory_limit);
+        proc->percent_mem = mem > 100.0f ? 100.0f : mem;
+    }
+}
+
+/**
+ * @brief Frees memory allocated for cgroup monitoring
+ *
+ * @param set Pointer to the cgroup set
+ */
+void cleanup_cgroups(CgroupSet *set) {
+    if (!set) return;
+
+    for (int i = 0; i < set->num_groups; i++) {
+        free(set->groups[i].path);
+    }
+    free(set->groups);
+    free(set->pids);
+    free(set->pid_groups);
+    free(set->root);
+    free(set->procs_buf);
+    free(set->members);
+    free(set);
+}
@@ -0,0 +1,126 @@
+#ifndef CGROUP_H
+#define CGROUP_H
+
+#include <stdio.h>
+#include <sys/time.h>
+#include "proc_data.h"
+
+/**
+ * @struct Cgroup
+ * @brief Usage and effective limits of one cgroup v2 directory
+ *
+ * Limits are effective limits: the tightest of the cgroup's own
+ * cpu.max/memory.max and those of all its ancestors, falling back to the
+ * whole machine when nothing on the path sets one.
+ */
+typedef struct {
+    char *path;                       /**< Path relative to the cgroup2 mount, "/" for the root */
+    unsigned long long usage_usec;    /**< cpu.stat usage_usec from the last read */
+    double cpu_limit;                 /**< Effective CPU limit in cores */
+    unsigned long long memory_current; /**< memory.current in bytes */
+    unsigned long long memory_limit;  /**< Effective memory limit in bytes */
+    double cpu_cores;                 /**< CPU used over the last interval, in cores */
+    float percent_cpu;                /**< cpu_cores relative to cpu_limit */
+    float percent_mem;                /**< memory_current relative to memory_limit */
+    int num_procs;                    /**< Processes attributed in the last sample */
+} Cgroup;
+
+/**
+ * @brief A member PID and the index of its cgroup
+ */
+typedef struct {
+    long pid;
+    int group;
+} CgroupMember;
+
+/**
+ * @struct CgroupSet
+ * @brief Every cgroup below the monitored root, plus PID membership
+ *
+ * Membership comes from each cgroup's cgroup.procs file, so attributing
+ * processes costs one file per cgroup rather than one per process.
+ */
+typedef struct {
+    char mount[FILENAME_MAX];   /**< cgroup2 mount point */
+    char *root;                 /**< Monitored subtree, relative to the mount */
+    int subtree_only;           /**< Scan only member PIDs instead of all of /proc */
+
+    Cgroup *groups;             /**< Cgroups in depth-first order, root first */
+    int num_groups;
+    int group_capacity;
+
+    long *pids;                 /**< Member PIDs, sorted ascending */
+    int *pid_groups;            /**< Index into groups for each entry of pids */
+    int num_pids;
+    int pid_capacity;
+
+    // Scratch space reused every update; cgroup.procs of a busy cgroup
+    // can be far larger than the other files
+    char *procs_buf;            /**< Contents of the last cgroup.procs read */
+    size_t procs_buf_size;
+    CgroupMember *members;      /**< Membership gathered during the walk, before sorting */
+    int members_capacity;
+
+    double num_cpus;            /**< Online CPUs, the CPU limit when nothing sets one */
+    unsigned long long total_memory; /**< Physical memory, the memory limit when nothing sets one */
+    struct timeval last_update; /**< Time of the previous update_cgroups() call */
+} CgroupSet;
+
+/**
+ * @brief Sets up cgroup v2 monitoring
+ *
+ * @param mount cgroup2 mount point, or NULL to look in /sys/fs/cgroup and
+ *              /sys/fs/cgroup/unified
+ * @param subtree Subtree to monitor relative to the mount. NULL or "/"
+ *                monitors the whole hierarchy and still scans all of /proc.
+ *                Any other path scans only the processes inside that subtree.
+ * @return Pointer to the new set, or NULL if no cgroup2 hierarchy is found
+ */
+CgroupSet* init_cgroups(const char *mount, const char *subtree);
+
+/**
+ * @brief Re-reads every cgroup below the monitored root
+ *
+ * Reads cgroup.procs, cpu.stat, cpu.max, memory.current and memory.max
+ * once per cgroup and recomputes CPU usage from the usage_usec delta.
+ * Should be called once per refresh tick, before the process scan.
+ *
+ * @param set Set returned by init_cgroups()
+ * @return 0 on success, -1 if the root cgroup cannot be read
+ */
+int update_cgroups(CgroupSet *set);
+
+/**
+ * @brief Refreshes the cgroups and scans the processes they cover
+ *
+ * Calls update_cgroups(), then reads only the member PIDs when monitoring
+ * a subtree, or all of /proc otherwise.
+ *
+ * @param set Cgroup set
+ * @param proc_data Receives a newly allocated process array
+ * @param capacity_hint Expected number of processes when scanning all of /proc, 0 if unknown
+ * @return Number of processes read, or -1 on error
+ */
+int get_cgroup_proc_data(CgroupSet *set, ProcData **proc_data, int capacity_hint);
+
+/**
+ * @brief Attributes processes to cgroups and rescales their percentages
+ *
+ * Sets each process's cgroup index and recomputes %CPU and %MEM relative
+ * to the effective limits of its cgroup instead of the whole machine.
+ * Must be called after update_process_metrics().
+ *
+ * @param set Set updated by update_cgroups() this tick
+ * @param proc_data Array of processes
+ * @param len Number of processes in the array
+ */
+void apply_cgroup_limits(CgroupSet *set, ProcData *proc_data, int len);
+
+/**
+ * @brief Frees a set returned by init_cgroups()
+ *
+ * @param set Pointer to the set to free (may be NULL)
+ */
+void cleanup_cgroups(CgroupSet *set);
+
+#endif /* CGROUP_H */
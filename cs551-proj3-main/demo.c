@@ -1,12 +1,31 @@
 #include "proc_monitor.h"
+#include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
-int main(char argc, char *argv[]) {
+// Usage: demo [-a alert_rules] [-g cgroup] [num_procs_display interval]
+int main(int argc, char *argv[]) {
     int num_procs_display = 10;
     int interval = 5;
-    if (argc == 3) {
-        num_procs_display = atoi(argv[1]);
-        interval = atoi(argv[2]);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "a:g:")) != -1) {
+        switch (opt) {
+            case 'a':
+                proc_monitor_set_alert_rules(optarg);
+                break;
+            case 'g':
+                proc_monitor_set_cgroup(optarg);
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [-a alert_rules] [-g cgroup] [num_procs_display interval]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+
+    if (argc - optind == 2) {
+        num_procs_display = atoi(argv[optind]);
+        interval = atoi(argv[optind + 1]);
     }
     return proc_monitor(num_procs_display, interval);
-}
\ No newline at end of file
+}
@@ -2,10 +2,31 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
 #include "proc_data.h"
 #include "proc_metrics.h"
+#include "sched_stats.h"
 #include "display.h"
 
+// Hosts with more cores than this get a one-character-per-core heatmap
+// instead of a detail line per core
+#define CORE_DETAIL_MAX 8
+#define HEATMAP_WIDTH 64
+
+// Busiest cgroups listed above the process table in cgroup mode
+#define CGROUP_DISPLAY_MAX 5
+
+static const char heatmap_ramp[] = " .:-=+*#%@";
+#define HEATMAP_OFFLINE 'x'
+
 void clear_screen() {
     printf("\033[2J\033[H");
 }
@@ -16,18 +37,37 @@ int compare_by_cpu(const void *a, const void *b) {
     return (proc_b->percent_cpu > proc_a->percent_cpu) - (proc_a->percent_cpu > proc_b->percent_cpu);
 }
 
+int compare_by_mem(const void *a, const void *b) {
+    ProcData *proc_a = (ProcData *)a;
+    ProcData *proc_b = (ProcData *)b;
+    return (proc_b->memory_size > proc_a->memory_size) - (proc_a->memory_size > proc_b->memory_size);
+}
+
+int compare_by_pid(const void *a, const void *b) {
+    ProcData *proc_a = (ProcData *)a;
+    ProcData *proc_b = (ProcData *)b;
+    return (proc_a->pid > proc_b->pid) - (proc_b->pid > proc_a->pid);
+}
+
+int compare_by_name(const void *a, const void *b) {
+    ProcData *proc_a = (ProcData *)a;
+    ProcData *proc_b = (ProcData *)b;
+    int cmp = strcmp(proc_a->name, proc_b->name);
+    return cmp != 0 ? cmp : compare_by_pid(a, b);
+}
+
+int compare_by_wait(const void *a, const void *b) {
+    ProcData *proc_a = (ProcData *)a;
+    ProcData *proc_b = (ProcData *)b;
+    return (proc_b->sched_wait > proc_a->sched_wait) - (proc_a->sched_wait > proc_b->sched_wait);
+}
+
+static void print_process_row(const ProcData *proc, int highlight, int sched, const CgroupSet *cgroups);
+
 void display_top_processes(ProcData *proc_data, int len, int num_procs_display) {
     int display_count = len < num_procs_display ? len : num_procs_display;
     for (int i = 0; i < display_count; i++) {
-        printf("%-20s %-10ld %-13s %-10.2f %-10.2f %-12ld %-10d %-10d\n",
-               proc_data[i].name, 
-               proc_data[i].pid, 
-               proc_data[i].state,
-               proc_data[i].percent_cpu, 
-               proc_data[i].percent_mem, 
-               proc_data[i].memory_size,
-               proc_data[i].priority,
-               proc_data[i].nice);
+        print_process_row(&proc_data[i], 0, 0, NULL);
     }
 }
 
@@ -44,56 +84,760 @@ void calculate_summary(ProcData *proc_data, int len, float *total_cpu, float *to
 void display_summary(float total_cpu, float total_memory, int num_processes) {
     printf("\nSummary:\n");
     printf("Total Processes: %d\n", num_processes);
+    printf("Total %%CPU: %.2f\n", total_cpu);
     printf("Total Memory Usage: %.2f MB\n", total_memory / 1024.0f);
     printf("------------------------------------------------------------------------------------------------------\n");
 }
 
-void truncate_names(ProcData *proc_data, int len, int num_procs_display) {
-    for (int i = 0; i < num_procs_display; i++) {
-        if (strnlen(proc_data[i].name, 4096) >= 20) {
-            proc_data[i].name[17] = '.';
-            proc_data[i].name[18] = '.';
-            proc_data[i].name[19] = '.';
-            proc_data[i].name[20] = '\0';
+static char heatmap_cell(float busy) {
+    int levels = (int)sizeof(heatmap_ramp) - 2;
+    int level = (int)(busy * levels / 100.0f + 0.5f);
+    if (level < 0) level = 0;
+    if (level > levels) level = levels;
+    return heatmap_ramp[level];
+}
+
+static void print_cpu_usage(const char *label, const CPUUsage *usage) {
+    printf("%-6s %5.1f%% busy  us %5.1f  sy %5.1f  wa %5.1f  st %5.1f\n",
+           label, usage->busy, usage->user, usage->sys, usage->iowait, usage->steal);
+}
+
+void display_system_header(const SysStats *stats) {
+    print_cpu_usage("CPU", &stats->total_usage);
+
+    if (stats->num_cpus <= CORE_DETAIL_MAX) {
+        char label[16];
+        for (int i = 0; i < stats->num_cpus; i++) {
+            snprintf(label, sizeof(label), "cpu%d", i);
+            if (sys_stats_cpu_online(stats, i)) {
+                print_cpu_usage(label, &stats->core_usage[i]);
+            } else {
+                printf("%-6s offline\n", label);
+            }
+        }
+    } else {
+        // One character per core, darker means busier, 'x' is offline
+        char row[HEATMAP_WIDTH + 1];
+        for (int start = 0; start < stats->num_cpus; start += HEATMAP_WIDTH) {
+            int n = stats->num_cpus - start < HEATMAP_WIDTH ? stats->num_cpus - start : HEATMAP_WIDTH;
+            for (int i = 0; i < n; i++) {
+                row[i] = sys_stats_cpu_online(stats, start + i) ? heatmap_cell(stats->core_usage[start + i].busy)
+                                                                : HEATMAP_OFFLINE;
+            }
+            row[n] = '\0';
+            printf("%4d-%-4d [%s]\n", start, start + n - 1, row);
         }
     }
+
+    unsigned long mem_used = stats->mem_total - stats->mem_available;
+    printf("Mem:  %.1f/%.1f MB used, %.1f MB free, %.1f MB buff/cache\n",
+           mem_used / 1024.0, stats->mem_total / 1024.0, stats->mem_free / 1024.0,
+           (stats->buffers + stats->cached) / 1024.0);
+    printf("Swap: %.1f/%.1f MB used\n",
+           (stats->swap_total - stats->swap_free) / 1024.0, stats->swap_total / 1024.0);
+    printf("Load average: %.2f %.2f %.2f  Tasks: %d running, %d total\n\n",
+           stats->load[0], stats->load[1], stats->load[2], stats->running_tasks, stats->total_tasks);
+}
+
+static void truncate_name(const char *name, char *out) {
+    if (strnlen(name, 4096) >= 20) {
+        memcpy(out, name, 17);
+        strcpy(out + 17, "...");
+    } else {
+        strcpy(out, name);
+    }
 }
 
-void refresh_display(ProcData *proc_data, int len, CPUDelta *deltas, int interval, int num_procs_display) {
+static const char* cgroup_label(const CgroupSet *cgroups, int index) {
+    if (!cgroups || index < 0 || index >= cgroups->num_groups) return "-";
+
+    const char *path = cgroups->groups[index].path;
+    const char *slash = strrchr(path, '/');
+    return (slash && slash[1] != '\0') ? slash + 1 : path;
+}
+
+static void print_process_row(const ProcData *proc, int highlight, int sched, const CgroupSet *cgroups) {
+    char name[21];
+    truncate_name(proc->name, name);
+    printf("%s%-20s %-10ld %-13s %-10.2f %-10.2f %-12ld %-10d %-10d",
+           highlight ? "\033[7m" : "",
+           name,
+           proc->pid,
+           proc->state,
+           proc->percent_cpu,
+           proc->percent_mem,
+           proc->memory_size,
+           proc->priority,
+           proc->nice);
+    if (sched) {
+        // Rows without a reading from the previous tick show "-"
+        char wait[16] = "-", migrations[16] = "-", cpu[16] = "-";
+        if (proc->sched_wait >= 0.0f) snprintf(wait, sizeof(wait), "%.2f", proc->sched_wait);
+        if (proc->migrations >= 0) snprintf(migrations, sizeof(migrations), "%ld", proc->migrations);
+        if (proc->last_cpu >= 0) snprintf(cpu, sizeof(cpu), "%d", proc->last_cpu);
+        printf(" %-10s %-6s %-4s", wait, migrations, cpu);
+    }
+    if (cgroups) {
+        char label[21];
+        truncate_name(cgroup_label(cgroups, proc->cgroup), label);
+        printf(" %-20s", label);
+    }
+    printf("%s\n", highlight ? "\033[0m" : "");
+}
+
+void display_cgroups(const CgroupSet *cgroups) {
+    // Pick the busiest cgroups without reordering the set; process rows
+    // refer to cgroups by index
+    int top[CGROUP_DISPLAY_MAX];
+    int num_top = 0;
+    for (int g = 0; g < cgroups->num_groups; g++) {
+        int pos = num_top < CGROUP_DISPLAY_MAX ? num_top++ : CGROUP_DISPLAY_MAX;
+        while (pos > 0 && cgroups->groups[top[pos - 1]].percent_cpu < cgroups->groups[g].percent_cpu) {
+            if (pos < CGROUP_DISPLAY_MAX) top[pos] = top[pos - 1];
+            pos--;
+        }
+        if (pos < CGROUP_DISPLAY_MAX) top[pos] = g;
+    }
+
+    printf("%-30s %-7s %-18s %-10s %-24s %-10s\n",
+           "Cgroup", "Procs", "CPU (cores)", "%CPU", "Memory (MB)", "%MEM");
+    for (int i = 0; i < num_top; i++) {
+        const Cgroup *group = &cgroups->groups[top[i]];
+        char path[31], cpu[32], memory[48];
+        truncate_name(group->path, path);
+        snprintf(cpu, sizeof(cpu), "%.2f/%.2f", group->cpu_cores, group->cpu_limit);
+        snprintf(memory, sizeof(memory), "%.1f/%.1f", group->memory_current / 1048576.0,
+                 group->memory_limit / 1048576.0);
+        printf("%-30s %-7d %-18s %-10.2f %-24s %-10.2f\n",
+               path, group->num_procs, cpu, group->percent_cpu, memory, group->percent_mem);
+    }
+    printf("\n");
+}
+
+/* ---------------------------------------------------------------------------
+ * Interactive event loop
+ *
+ * The loop multiplexes three file descriptors with poll(): the terminal,
+ * a timerfd that fires every refresh interval, and a signalfd carrying
+ * SIGWINCH and the termination signals. Only timer expirations scan /proc;
+ * every key press re-renders the cached snapshot.
+ * ------------------------------------------------------------------------- */
+
+#define INPUT_MAX 64
+#define MESSAGE_MAX 160
+
+// Lines the layout needs besides the process rows: column header (2),
+// summary (6) and status line (1)
+#define TABLE_CHROME_LINES 9
+
+typedef enum {
+    INPUT_NORMAL,
+    INPUT_FILTER,
+    INPUT_KILL,
+    INPUT_RENICE
+} InputMode;
+
+typedef struct {
+    ProcData *procs;        // Cached snapshot being displayed
+    int len;
+    int *view;              // Indices into procs that pass the filter, in sort order
+    int view_len;
+    int view_cap;
+
+    SortKey sort_key;
+    int num_procs_display;
+    int scroll;             // First view row on screen
+    int selected;           // Selected view row
+    long selected_pid;      // Keeps the selection on the same process across re-sorts
+    long target_pid;        // Process a kill or renice prompt was opened for
+    unsigned long long target_start_time;
+    int paused;
+    char filter[INPUT_MAX];
+
+    InputMode mode;
+    char input[INPUT_MAX];
+    int input_len;
+    char message[MESSAGE_MAX];
+
+    int term_rows;
+    int sampled;            // Set once the first timed sample has replaced the priming one
+    int sched_columns;      // Show run-queue wait, migrations and last CPU
+    CgroupSet *cgroups;     // Non-NULL in cgroup mode
+    CgroupSet cgroup_view;  // Copy of the cgroups procs refers to, frozen with it while paused
+} DisplayState;
+
+static struct termios saved_termios;
+static volatile sig_atomic_t termios_saved = 0;
+static volatile sig_atomic_t display_active = 0;
+
+static int (*const comparators[])(const void *, const void *) = {
+    [SORT_CPU] = compare_by_cpu,
+    [SORT_MEM] = compare_by_mem,
+    [SORT_PID] = compare_by_pid,
+    [SORT_NAME] = compare_by_name,
+    [SORT_WAIT] = compare_by_wait,
+};
+
+static const char *sort_names[] = {
+    [SORT_CPU] = "%CPU",
+    [SORT_MEM] = "%MEM",
+    [SORT_PID] = "PID",
+    [SORT_NAME] = "Name",
+    [SORT_WAIT] = "Wait",
+};
+
+static void fatal_signal_handler(int sig) {
+    cleanup_display();
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+// Raw mode, alternate screen and hidden cursor; undone by cleanup_display()
+static void enter_terminal(void) {
+    if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_termios) == 0) {
+        struct termios raw = saved_termios;
+        raw.c_lflag &= ~(ICANON | ECHO);
+        raw.c_cc[VMIN] = 0;
+        raw.c_cc[VTIME] = 0;
+        termios_saved = 1;
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+    }
+
+    display_active = 1;
     printf("\033[?1049h");
     printf("\033[?25l");
-    
-    while (1) {
-        len = get_proc_data(&proc_data);
-        if (len <= 0) {
-            fprintf(stderr, "Error refreshing process data\n");
-            break;
+    fflush(stdout);
+}
+
+static void setup_terminal(void) {
+    enter_terminal();
+
+    // Whatever way the process ends, the terminal must come back
+    atexit(cleanup_display);
+    int fatal_signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGABRT };
+    for (size_t i = 0; i < sizeof(fatal_signals) / sizeof(fatal_signals[0]); i++) {
+        signal(fatal_signals[i], fatal_signal_handler);
+    }
+}
+
+static int terminal_rows(void) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0) {
+        return ws.ws_row;
+    }
+    return 0;
+}
+
+static int header_lines(const SysStats *stats) {
+    int cpu_lines = stats->num_cpus <= CORE_DETAIL_MAX ? stats->num_cpus
+                                                      : (stats->num_cpus + HEATMAP_WIDTH - 1) / HEATMAP_WIDTH;
+    return 1 + cpu_lines + 4;
+}
+
+/**
+ * Process rows refer to cgroups by index, and update_cgroups() rebuilds the
+ * list every tick, so the snapshot keeps its own copy of the groups.
+ */
+static void snapshot_cgroups(DisplayState *st) {
+    if (!st->cgroups) return;
+
+    CgroupSet *view = &st->cgroup_view;
+    for (int i = 0; i < view->num_groups; i++) {
+        free(view->groups[i].path);
+    }
+    view->num_groups = 0;
+
+    if (st->cgroups->num_groups > view->group_capacity) {
+        Cgroup *groups = realloc(view->groups, st->cgroups->num_groups * sizeof(Cgroup));
+        if (!groups) return;
+        view->groups = groups;
+        view->group_capacity = st->cgroups->num_groups;
+    }
+
+    for (int i = 0; i < st->cgroups->num_groups; i++) {
+        view->groups[i] = st->cgroups->groups[i];
+        view->groups[i].path = strdup(st->cgroups->groups[i].path);
+        if (!view->groups[i].path) break;
+        view->num_groups++;
+    }
+}
+
+static void free_cgroup_snapshot(DisplayState *st) {
+    for (int i = 0; i < st->cgroup_view.num_groups; i++) {
+        free(st->cgroup_view.groups[i].path);
+    }
+    free(st->cgroup_view.groups);
+}
+
+static const CgroupSet* shown_cgroups(const DisplayState *st) {
+    return st->cgroups ? &st->cgroup_view : NULL;
+}
+
+static int cgroup_lines(const CgroupSet *cgroups) {
+    if (!cgroups) return 0;
+    return 2 + (cgroups->num_groups < CGROUP_DISPLAY_MAX ? cgroups->num_groups : CGROUP_DISPLAY_MAX);
+}
+
+static int visible_rows(const DisplayState *st, const SysStats *stats) {
+    int rows = st->num_procs_display;
+    if (st->term_rows > 0) {
+        int fit = st->term_rows - header_lines(stats) - cgroup_lines(shown_cgroups(st)) - TABLE_CHROME_LINES;
+        if (fit < 1) fit = 1;
+        if (rows > fit) rows = fit;
+    }
+    return rows;
+}
+
+static int matches_filter(const DisplayState *st, const ProcData *proc) {
+    return st->filter[0] == '\0' || strstr(proc->name, st->filter) != NULL;
+}
+
+/**
+ * Sorts the snapshot and rebuilds the filtered view, keeping the selection
+ * on the same PID when it is still present.
+ */
+static void rebuild_view(DisplayState *st) {
+    if (st->len > st->view_cap) {
+        int *view = realloc(st->view, st->len * sizeof(int));
+        if (!view) {
+            st->view_len = 0;
+            return;
         }
+        st->view = view;
+        st->view_cap = st->len;
+    }
 
-        update_process_metrics(proc_data, len, deltas);
-        qsort(proc_data, len, sizeof(ProcData), compare_by_cpu);
+    qsort(st->procs, st->len, sizeof(ProcData), comparators[st->sort_key]);
 
-        truncate_names(proc_data, len, num_procs_display);
-        
-        printf("\033[H\033[2J");
-        
-        printf("%-20s %-10s %-13s %-10s %-10s %-12s %-10s %-10s\n",
-               "Name", "PID", "State", "%CPU", "%MEM", "Memory (KB)", "Priority", "Nice");
-        printf("------------------------------------------------------------------------------------------------------\n");
+    st->view_len = 0;
+    for (int i = 0; i < st->len; i++) {
+        if (matches_filter(st, &st->procs[i])) {
+            if (st->procs[i].pid == st->selected_pid) {
+                st->selected = st->view_len;
+            }
+            st->view[st->view_len++] = i;
+        }
+    }
+}
 
-        display_top_processes(proc_data, len, num_procs_display);
+static void clamp_selection(DisplayState *st, int rows) {
+    if (st->selected >= st->view_len) st->selected = st->view_len - 1;
+    if (st->selected < 0) st->selected = 0;
+    if (st->selected < st->scroll) st->scroll = st->selected;
+    if (st->selected >= st->scroll + rows) st->scroll = st->selected - rows + 1;
+    if (st->scroll > st->view_len - rows) st->scroll = st->view_len - rows;
+    if (st->scroll < 0) st->scroll = 0;
+    st->selected_pid = st->view_len > 0 ? st->procs[st->view[st->selected]].pid : 0;
+}
 
-        float total_cpu = 0.0f;
-        float total_memory = 0.0f;
-        calculate_summary(proc_data, len, &total_cpu, &total_memory);
-        display_summary(total_cpu, total_memory, len);
+static void render(DisplayState *st, const SysStats *stats) {
+    printf("\033[H\033[2J");
 
+    if (!st->sampled) {
+        printf("Collecting first sample...\n");
         fflush(stdout);
-        sleep(interval);
+        return;
+    }
+
+    display_system_header(stats);
+    if (st->cgroups) {
+        display_cgroups(shown_cgroups(st));
+    }
+
+    int rows = visible_rows(st, stats);
+    clamp_selection(st, rows);
+
+    printf("%-20s %-10s %-13s %-10s %-10s %-12s %-10s %-10s%s%s\n",
+           "Name", "PID", "State", "%CPU", "%MEM", "Memory (KB)", "Priority", "Nice",
+           st->sched_columns ? " Wait(ms/s) Migr   CPU " : "",
+           st->cgroups ? " Cgroup" : "");
+    printf("------------------------------------------------------------------------------------------------------\n");
+
+    for (int i = st->scroll; i < st->view_len && i < st->scroll + rows; i++) {
+        print_process_row(&st->procs[st->view[i]], i == st->selected, st->sched_columns, shown_cgroups(st));
+    }
+
+    float total_cpu = 0.0f;
+    float total_memory = 0.0f;
+    calculate_summary(st->procs, st->len, &total_cpu, &total_memory);
+    display_summary(total_cpu, total_memory, st->len);
+
+    switch (st->mode) {
+        case INPUT_FILTER:
+            printf("Filter: %s", st->input);
+            break;
+        case INPUT_KILL:
+            printf("Signal to send to PID %ld [15]: %s", st->target_pid, st->input);
+            break;
+        case INPUT_RENICE:
+            printf("Renice PID %ld to: %s", st->target_pid, st->input);
+            break;
+        default:
+            if (st->message[0] != '\0') {
+                printf("%s", st->message);
+            } else {
+                printf("Sort: %s  Rows: %d  %s%s%s%s | q quit  c/m/p/n/w sort  l sched  +/- rows  space pause  / filter  k kill  r renice",
+                       sort_names[st->sort_key], st->num_procs_display,
+                       st->paused ? "[PAUSED]  " : "",
+                       st->filter[0] ? "Filter: \"" : "", st->filter, st->filter[0] ? "\"  " : "");
+            }
+            break;
+    }
+
+    fflush(stdout);
+}
+
+/**
+ * Reads the scheduler counters only for the rows that need them. When
+ * sorting by wait time, every row that passes the filter needs its run-queue
+ * wait; migrations come from much larger debug files and are read only for
+ * the rows on screen. The base scan never opens any of these files.
+ */
+static void sample_sched_stats(DisplayState *st, PidTable *table, const SysStats *sys_stats) {
+    if (st->sort_key == SORT_WAIT) {
+        for (int i = 0; i < st->len; i++) {
+            if (matches_filter(st, &st->procs[i])) {
+                update_sched_wait(&st->procs[i], table);
+            }
+        }
+        rebuild_view(st);
+    }
+    if (!st->sched_columns) return;
+
+    int rows = visible_rows(st, sys_stats);
+    clamp_selection(st, rows);
+    for (int i = st->scroll; i < st->view_len && i < st->scroll + rows; i++) {
+        ProcData *proc = &st->procs[st->view[i]];
+        if (st->sort_key != SORT_WAIT) {
+            update_sched_wait(proc, table);
+        }
+        update_sched_migrations(proc, table);
     }
 }
 
+/**
+ * Scans /proc and updates every metric. Alerts keep being evaluated while
+ * paused; only the displayed snapshot stays frozen.
+ */
+static void sample(DisplayState *st, PidTable *table, SysStats *sys_stats, AlertEngine *alerts) {
+    ProcData *procs = NULL;
+
+    // The task count from the previous tick sizes the array, so /proc/loadavg
+    // is only read once per tick, by update_sys_stats()
+    int hint = sys_stats->total_tasks;
+    int len = st->cgroups ? get_cgroup_proc_data(st->cgroups, &procs, hint) : get_proc_data(&procs, hint);
+    if (len < 0) {
+        free(procs);
+        snprintf(st->message, sizeof(st->message), "Error refreshing process data");
+        return;
+    }
+
+    if (update_sys_stats(sys_stats) == -1) {
+        snprintf(st->message, sizeof(st->message), "Error refreshing system statistics");
+    }
+
+    update_process_metrics(procs, len, table);
+    apply_cgroup_limits(st->cgroups, procs, len);
+    evaluate_alerts(alerts, procs, len, table);
+
+    if (st->paused) {
+        free(procs);
+        return;
+    }
+
+    free(st->procs);
+    st->procs = procs;
+    st->len = len;
+    st->sampled = 1;
+    snapshot_cgroups(st);
+    rebuild_view(st);
+    sample_sched_stats(st, table, sys_stats);
+}
+
+/**
+ * The selection can move to another process while a prompt is open, and
+ * the snapshot can be much older than the process table, especially while
+ * paused. Before acting, make sure the process the prompt was opened for
+ * is still in the snapshot and its PID has not been reused since.
+ */
+static int target_is_current(DisplayState *st, const char *action) {
+    int in_snapshot = 0;
+    for (int i = 0; i < st->len; i++) {
+        if (st->procs[i].pid == st->target_pid && st->procs[i].start_time == st->target_start_time) {
+            in_snapshot = 1;
+            break;
+        }
+    }
+
+    unsigned long long start_time;
+    if (!in_snapshot || get_proc_start_time(st->target_pid, &start_time) == -1 ||
+        start_time != st->target_start_time) {
+        snprintf(st->message, sizeof(st->message), "%s %ld: process has exited", action, st->target_pid);
+        return 0;
+    }
+    return 1;
+}
+
+static void apply_prompt(DisplayState *st) {
+    char *end;
+    long value;
+
+    switch (st->mode) {
+        case INPUT_FILTER:
+            snprintf(st->filter, sizeof(st->filter), "%s", st->input);
+            st->selected = 0;
+            st->scroll = 0;
+            rebuild_view(st);
+            break;
+        case INPUT_KILL:
+            value = st->input_len > 0 ? strtol(st->input, &end, 10) : SIGTERM;
+            if (st->input_len > 0 && *end != '\0') {
+                snprintf(st->message, sizeof(st->message), "Invalid signal: %s", st->input);
+            } else if (target_is_current(st, "kill")) {
+                if (kill((pid_t)st->target_pid, (int)value) == -1) {
+                    snprintf(st->message, sizeof(st->message), "kill %ld: %s", st->target_pid, strerror(errno));
+                } else {
+                    snprintf(st->message, sizeof(st->message), "Sent signal %ld to PID %ld", value, st->target_pid);
+                }
+            }
+            break;
+        case INPUT_RENICE:
+            value = strtol(st->input, &end, 10);
+            if (st->input_len == 0 || *end != '\0') {
+                snprintf(st->message, sizeof(st->message), "Invalid nice value: %s", st->input);
+            } else if (target_is_current(st, "renice")) {
+                if (setpriority(PRIO_PROCESS, (id_t)st->target_pid, (int)value) == -1) {
+                    snprintf(st->message, sizeof(st->message), "renice %ld: %s", st->target_pid, strerror(errno));
+                } else {
+                    snprintf(st->message, sizeof(st->message), "Reniced PID %ld to %ld", st->target_pid, value);
+                }
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+static void start_prompt(DisplayState *st, InputMode mode) {
+    if (mode != INPUT_FILTER) {
+        if (st->view_len == 0 || st->selected_pid == 0) return;
+
+        // Pin the target now; the selected row may change under the prompt
+        const ProcData *proc = &st->procs[st->view[st->selected]];
+        st->target_pid = proc->pid;
+        st->target_start_time = proc->start_time;
+    }
+    st->mode = mode;
+    st->input_len = 0;
+    st->input[0] = '\0';
+}
+
+static void handle_prompt_key(DisplayState *st, char c) {
+    if (c == '\n' || c == '\r') {
+        apply_prompt(st);
+        st->mode = INPUT_NORMAL;
+    } else if (c == 27) {
+        st->mode = INPUT_NORMAL;
+    } else if (c == 127 || c == '\b') {
+        if (st->input_len > 0) st->input[--st->input_len] = '\0';
+    } else if (c >= 32 && c < 127 && st->input_len < INPUT_MAX - 1) {
+        st->input[st->input_len++] = c;
+        st->input[st->input_len] = '\0';
+    }
+}
+
+static void set_sort_key(DisplayState *st, SortKey key) {
+    st->sort_key = key;
+    rebuild_view(st);
+}
+
+/**
+ * Handles one chunk of terminal input. Returns 0 when the user asked to quit.
+ */
+static int handle_input(DisplayState *st, const char *buf, ssize_t n, int rows) {
+    for (ssize_t i = 0; i < n; i++) {
+        char c = buf[i];
+
+        // Arrow and paging keys arrive as "ESC [ X" or "ESC [ N ~"
+        if (c == 27 && i + 2 < n && buf[i + 1] == '[') {
+            char code = buf[i + 2];
+            i += 2;
+            if ((code == '5' || code == '6') && i + 1 < n && buf[i + 1] == '~') i++;
+            if (st->mode != INPUT_NORMAL) continue;
+
+            switch (code) {
+                case 'A': st->selected--; break;
+                case 'B': st->selected++; break;
+                case '5': st->selected -= rows; break;
+                case '6': st->selected += rows; break;
+                case 'H': st->selected = 0; break;
+                case 'F': st->selected = st->view_len - 1; break;
+            }
+            clamp_selection(st, rows);
+            continue;
+        }
+
+        if (st->mode != INPUT_NORMAL) {
+            handle_prompt_key(st, c);
+            continue;
+        }
+
+        st->message[0] = '\0';
+        switch (c) {
+            case 'q': return 0;
+            case 'c': set_sort_key(st, SORT_CPU); break;
+            case 'm': set_sort_key(st, SORT_MEM); break;
+            case 'p': set_sort_key(st, SORT_PID); break;
+            case 'n': set_sort_key(st, SORT_NAME); break;
+            case 'w':
+                st->sched_columns = 1;
+                set_sort_key(st, SORT_WAIT);
+                break;
+            case 'l':
+                st->sched_columns = !st->sched_columns;
+                if (!st->sched_columns && st->sort_key == SORT_WAIT) set_sort_key(st, SORT_CPU);
+                break;
+            case '+': st->num_procs_display++; break;
+            case '-': if (st->num_procs_display > 1) st->num_procs_display--; break;
+            case ' ': st->paused = !st->paused; break;
+            case '/': start_prompt(st, INPUT_FILTER); break;
+            case 'k': start_prompt(st, INPUT_KILL); break;
+            case 'r': start_prompt(st, INPUT_RENICE); break;
+        }
+    }
+    return 1;
+}
+
+void refresh_display(ProcData *proc_data, int len, PidTable *table, SysStats *sys_stats, AlertEngine *alerts,
+                     CgroupSet *cgroups, int interval, int num_procs_display) {
+    DisplayState st;
+    memset(&st, 0, sizeof(st));
+    st.procs = proc_data;
+    st.len = len;
+    st.cgroups = cgroups;
+    snapshot_cgroups(&st);
+    st.sort_key = SORT_CPU;
+    st.num_procs_display = num_procs_display > 0 ? num_procs_display : 1;
+    rebuild_view(&st);
+
+    // Route resizes and termination requests through the poll loop
+    sigset_t mask, old_mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGWINCH);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGQUIT);
+    sigaddset(&mask, SIGTSTP);
+    sigaddset(&mask, SIGCONT);
+    if (sigprocmask(SIG_BLOCK, &mask, &old_mask) == -1) {
+        perror("sigprocmask");
+        free(st.procs);
+        free(st.view);
+        free_cgroup_snapshot(&st);
+        return;
+    }
+
+    int sig_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (sig_fd == -1 || timer_fd == -1) {
+        perror("signalfd/timerfd_create");
+        if (sig_fd != -1) close(sig_fd);
+        if (timer_fd != -1) close(timer_fd);
+        sigprocmask(SIG_SETMASK, &old_mask, NULL);
+        free(st.procs);
+        free(st.view);
+        free_cgroup_snapshot(&st);
+        return;
+    }
+
+    // The priming sample has no real CPU baseline, so take the first timed
+    // sample after one second and then settle into the requested interval
+    struct itimerspec timer;
+    memset(&timer, 0, sizeof(timer));
+    timer.it_value.tv_sec = 1;
+    timer.it_interval.tv_sec = interval > 0 ? interval : 1;
+    timerfd_settime(timer_fd, 0, &timer, NULL);
+
+    setup_terminal();
+    st.term_rows = terminal_rows();
+
+    struct pollfd fds[3] = {
+        { .fd = timer_fd, .events = POLLIN },
+        { .fd = sig_fd, .events = POLLIN },
+        // Without a terminal there is nothing to read, so poll ignores it
+        { .fd = termios_saved ? STDIN_FILENO : -1, .events = POLLIN },
+    };
+
+    int running = 1;
+    render(&st, sys_stats);
+    while (running) {
+        if (poll(fds, 3, -1) == -1) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            uint64_t expirations;
+            if (read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+                sample(&st, table, sys_stats, alerts);
+            }
+        }
+
+        if (fds[1].revents & POLLIN) {
+            struct signalfd_siginfo info;
+            if (read(sig_fd, &info, sizeof(info)) == sizeof(info)) {
+                if (info.ssi_signo == SIGWINCH) {
+                    st.term_rows = terminal_rows();
+                } else if (info.ssi_signo == SIGTSTP) {
+                    // Give the shell its terminal back before stopping
+                    cleanup_display();
+                    raise(SIGSTOP);
+                } else if (info.ssi_signo == SIGCONT) {
+                    enter_terminal();
+                    st.term_rows = terminal_rows();
+                } else {
+                    running = 0;
+                }
+            }
+        }
+
+        if (fds[2].revents & POLLIN) {
+            char buf[INPUT_MAX];
+            ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+            if (n > 0) {
+                running = handle_input(&st, buf, n, visible_rows(&st, sys_stats));
+            }
+        } else if (fds[2].revents & (POLLHUP | POLLERR)) {
+            running = 0;
+        }
+
+        if (running) {
+            render(&st, sys_stats);
+        }
+    }
+
+    cleanup_display();
+    close(timer_fd);
+    close(sig_fd);
+    sigprocmask(SIG_SETMASK, &old_mask, NULL);
+    free(st.procs);
+    free(st.view);
+    free_cgroup_snapshot(&st);
+}
+
 void cleanup_display() {
-    printf("\033[?1049l");
-    printf("\033[?25h");
+    // Async-signal-safe: also runs from signal handlers and atexit
+    if (termios_saved) {
+        tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved_termios);
+        termios_saved = 0;
+    }
+    if (display_active) {
+        static const char restore[] = "\033[?1049l\033[?25h";
+        display_active = 0;
+        if (write(STDOUT_FILENO, restore, sizeof(restore) - 1) == -1) {
+            return;
+        }
+    }
 }
@@ -30,13 +30,32 @@
 
 #include "proc_data.h"
 #include "proc_metrics.h"
+#include "sys_stats.h"
+#include "pid_table.h"
+#include "alerts.h"
+#include "cgroup.h"
+
+typedef enum {
+    SORT_CPU,
+    SORT_MEM,
+    SORT_PID,
+    SORT_NAME,
+    SORT_WAIT
+} SortKey;
 
 void clear_screen(void);
 int compare_by_cpu(const void *a, const void *b);
+int compare_by_mem(const void *a, const void *b);
+int compare_by_pid(const void *a, const void *b);
+int compare_by_name(const void *a, const void *b);
+int compare_by_wait(const void *a, const void *b);
 void display_top_processes(ProcData *proc_data, int len, int num_procs_display);
 void calculate_summary(ProcData *proc_data, int len, float *total_cpu, float *total_memory);
 void display_summary(float total_cpu, float total_memory, int num_processes);
-void refresh_display(ProcData *proc_data, int len, CPUDelta *deltas, int interval, int num_procs_display);
+void display_system_header(const SysStats *stats);
+void display_cgroups(const CgroupSet *cgroups);
+void refresh_display(ProcData *proc_data, int len, PidTable *table, SysStats *sys_stats, AlertEngine *alerts,
+                     CgroupSet *cgroups, int interval, int num_procs_display);
 void cleanup_display(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "pid_table.h"
+
+#define PID_TABLE_MIN_CAPACITY 64
+
+static int capacity_for(int count) {
+    // Keep the load factor at or below one half
+    int capacity = PID_TABLE_MIN_CAPACITY;
+    while (capacity < count * 2) capacity *= 2;
+    return capacity;
+}
+
+static unsigned int hash_pid(long pid) {
+    // Fibonacci hashing spreads sequential PIDs across the table
+    return (unsigned int)(((unsigned long long)pid * 11400714819323198485ull) >> 32);
+}
+
+static PidEntry* probe(PidEntry *slots, int capacity, long pid) {
+    unsigned int mask = (unsigned int)capacity - 1;
+    unsigned int i = hash_pid(pid) & mask;
+    while (slots[i].pid != 0 && slots[i].pid != pid) {
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static int rehash(PidTable *table, int capacity, int live_only) {
+    PidEntry *slots = calloc(capacity, sizeof(PidEntry));
+    if (!slots) return -1;
+
+    int count = 0;
+    for (int i = 0; i < table->capacity; i++) {
+        PidEntry *entry = &table->slots[i];
+        if (entry->pid == 0) continue;
+        if (live_only && entry->seen_tick != table->tick) continue;
+        *probe(slots, capacity, entry->pid) = *entry;
+        count++;
+    }
+
+    free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+    table->count = count;
+    return 0;
+}
+
+/**
+ * @brief Allocates an empty PID table
+ *
+ * @param capacity_hint Expected number of processes
+ * @return PidTable* Pointer to the new table, NULL if error
+ */
+PidTable* init_pid_table(int capacity_hint) {
+    PidTable *table = malloc(sizeof(PidTable));
+    if (!table) return NULL;
+
+    table->capacity = capacity_for(capacity_hint);
+    table->slots = calloc(table->capacity, sizeof(PidEntry));
+    if (!table->slots) {
+        free(table);
+        return NULL;
+    }
+    table->count = 0;
+    table->tick = 1;
+    get_metrics_time(&table->last_sweep);
+
+    return table;
+}
+
+/**
+ * @brief Finds or creates the entry for a process and marks it as seen
+ *
+ * @param table PID table
+ * @param pid Process ID
+ * @param start_time Process start time
+ * @return PidEntry* Pointer to the entry, NULL if error
+ */
+PidEntry* pid_table_get(PidTable *table, long pid, unsigned long long start_time) {
+    if (!table || pid <= 0) return NULL;
+
+    if ((table->count + 1) * 2 > table->capacity) {
+        if (rehash(table, table->capacity * 2, 0) == -1) return NULL;
+    }
+
+    PidEntry *entry = probe(table->slots, table->capacity, pid);
+    if (entry->pid == 0 || entry->start_time != start_time) {
+        if (entry->pid == 0) table->count++;
+        memset(entry, 0, sizeof(PidEntry));
+        entry->pid = pid;
+        entry->start_time = start_time;
+        entry->cpu.prev_time = table->last_sweep;
+    }
+    entry->seen_tick = table->tick;
+
+    return entry;
+}
+
+/**
+ * @brief Looks up an existing entry
+ *
+ * @param table PID table
+ * @param pid Process ID
+ * @return PidEntry* Pointer to the entry, NULL if not found
+ */
+PidEntry* pid_table_find(PidTable *table, long pid) {
+    if (!table || pid <= 0) return NULL;
+
+    PidEntry *entry = probe(table->slots, table->capacity, pid);
+    return entry->pid == pid ? entry : NULL;
+}
+
+/**
+ * @brief Drops entries of processes that have exited and advances the tick
+ *
+ * @param table PID table
+ * @return int 0 on success, -1 if error
+ */
+int pid_table_sweep(PidTable *table) {
+    if (!table) return -1;
+
+    int live = 0;
+    for (int i = 0; i < table->capacity; i++) {
+        if (table->slots[i].pid != 0 && table->slots[i].seen_tick == table->tick) {
+            live++;
+        }
+    }
+
+    if (live != table->count || capacity_for(live) < table->capacity / 2) {
+        if (rehash(table, capacity_for(live), 1) == -1) return -1;
+    }
+
+    table->tick++;
+    get_metrics_time(&table->last_sweep);
+    return 0;
+}
+
+/**
+ * @brief Frees memory allocated for the PID table
+ *
+ * @param table Pointer to the table
+ */
+void cleanup_pid_table(PidTable *table) {
+    if (!table) return;
+
+    free(table->slots);
+    free(table);
+}
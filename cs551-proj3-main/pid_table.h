@@ -0,0 +1,102 @@
+#ifndef PID_TABLE_H
+#define PID_TABLE_H
+
+#include <sys/time.h>
+#include "proc_metrics.h"
+
+/** Maximum number of alert rules whose per-process state fits in an entry */
+#define PID_TABLE_MAX_RULES 32
+
+/** Largest consecutive-match count an entry can hold for one rule */
+#define PID_TABLE_MAX_STREAK 65535
+
+/**
+ * @struct PidEntry
+ * @brief Per-process state that has to survive between refresh ticks
+ *
+ * An entry is keyed by PID and the process start time, so a recycled PID
+ * starts from a clean entry instead of inheriting the old process's state.
+ */
+typedef struct {
+    long pid;                      /**< Process ID, 0 marks an empty slot */
+    unsigned long long start_time; /**< Start time in clock ticks since boot */
+    unsigned int seen_tick;        /**< Last tick the process was scanned in */
+    CPUDelta cpu;                  /**< Previous CPU measurements */
+
+    long prev_rss;                 /**< RSS (KB) at the last alert evaluation */
+    unsigned int alert_tick;       /**< Alert tick prev_rss was recorded in */
+    unsigned int alert_active;     /**< Bitmask of rules currently firing */
+    unsigned short alert_streak[PID_TABLE_MAX_RULES]; /**< Consecutive matching ticks per rule */
+
+    unsigned long long prev_run_delay; /**< Run-queue wait (ns) summed over threads at the last read */
+    int wait_threads;              /**< Threads summed into prev_run_delay */
+    unsigned int wait_tick;        /**< Tick prev_run_delay was read in, 0 if not read */
+    struct timeval wait_time;      /**< Time prev_run_delay was read */
+    unsigned long long prev_migrations; /**< se.nr_migrations summed over threads at the last read */
+    int migrations_threads;        /**< Threads summed into prev_migrations */
+    unsigned int migrations_tick;  /**< Tick prev_migrations was read in, 0 if not read */
+} PidEntry;
+
+/**
+ * @struct PidTable
+ * @brief Open-addressing hash table of PidEntry keyed by PID
+ */
+typedef struct PidTable {
+    PidEntry *slots;           /**< Slot array, capacity is a power of two */
+    int capacity;              /**< Number of slots */
+    int count;                 /**< Number of occupied slots */
+    unsigned int tick;         /**< Current refresh tick */
+    struct timeval last_sweep; /**< Time of the last sweep (or creation) */
+} PidTable;
+
+/**
+ * @brief Allocates an empty PID table
+ *
+ * @param capacity_hint Expected number of processes (may be 0)
+ * @return Pointer to the new table, or NULL if allocation fails
+ */
+PidTable* init_pid_table(int capacity_hint);
+
+/**
+ * @brief Finds or creates the entry for a process and marks it as seen
+ *
+ * A new entry starts with zero previous CPU time measured from the last
+ * sweep, so a process born between two ticks is charged only for the CPU
+ * it used inside that interval. If the PID exists with a different start
+ * time, the entry is reset.
+ *
+ * @param table PID table
+ * @param pid Process ID
+ * @param start_time Process start time from /proc/<pid>/stat
+ * @return Pointer to the entry (valid until the next sweep), or NULL if allocation fails
+ */
+PidEntry* pid_table_get(PidTable *table, long pid, unsigned long long start_time);
+
+/**
+ * @brief Looks up an existing entry without creating or touching it
+ *
+ * @param table PID table
+ * @param pid Process ID
+ * @return Pointer to the entry, or NULL if the PID is not in the table
+ */
+PidEntry* pid_table_find(PidTable *table, long pid);
+
+/**
+ * @brief Drops entries not seen during the current tick and starts the next one
+ *
+ * The table is rebuilt when entries are dropped, and shrinks with the
+ * process count, so memory stays proportional to the live processes.
+ *
+ * @param table PID table
+ * @return 0 on success, -1 if allocation fails (the table is left unchanged)
+ */
+int pid_table_sweep(PidTable *table);
+
+/**
+ * @brief Frees a table allocated by init_pid_table()
+ *
+ * @param table Pointer to the table to free (may be NULL)
+ */
+void cleanup_pid_table(PidTable *table);
+
+#endif /* PID_TABLE_H */
@@ -4,10 +4,26 @@
 #include <sys/resource.h>
 #include <dirent.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include "proc_data.h"
 #include "display.h"
 
 
+// Initial capacity when /proc/loadavg gives no process count
+#define PROC_DATA_MIN_CAPACITY 64
+
+static char proc_root[FILENAME_MAX] = "/proc";
+
+void set_proc_root(const char *root) {
+    snprintf(proc_root, sizeof(proc_root), "%s", root ? root : "/proc");
+}
+
+const char* get_proc_root(void) {
+    return proc_root;
+}
+
 // For debugging
 void print_proc_data(ProcData *proc_data, int len) {
     for (int i = 0; i < len; i++) {
@@ -32,23 +48,40 @@ char is_integer(const char *dir_name) {
     return 1;
 }
 
-int get_num_procs() {
-    int num;
-    FILE *loadavg = fopen("/proc/loadavg", "r");
-    if (loadavg == NULL) {
-        perror("fopen");
+ssize_t read_proc_file(const char *path, char *buf, size_t size) {
+    if (size == 0) {
         return -1;
     }
 
-    char line[256];
-    if (fgets(line, sizeof(line), loadavg) != NULL) {
-        sscanf(line, "%*f %*f %*f %*d/%d", &num);
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return -1;
     }
 
-    if (fclose(loadavg) == EOF) {
-        perror("fclose");
+    // /proc files are generated in one go, so a single read returns a
+    // consistent snapshot as long as the buffer is large enough
+    ssize_t len = read(fd, buf, size - 1);
+    if (close(fd) == -1 || len < 0) {
+        return -1;
+    }
+    buf[len] = '\0';
+
+    return len;
+}
+
+int get_num_procs() {
+    int num = -1;
+    char loadavg_path[FILENAME_MAX];
+    if (snprintf(loadavg_path, sizeof(loadavg_path), "%s/loadavg", proc_root) >= (int)sizeof(loadavg_path)) {
+        return -1;
+    }
+
+    char line[256];
+    if (read_proc_file(loadavg_path, line, sizeof(line)) == -1) {
+        perror("read_proc_file");
         return -1;
     }
+    sscanf(line, "%*f %*f %*f %*d/%d", &num);
 
     return num;
 }
@@ -70,121 +103,205 @@ void init_procdata(ProcData **proc_data, int len) {
         (*proc_data)[i].pid = 0;
         (*proc_data)[i].priority = 0;
         (*proc_data)[i].sys_time = 0.0;
+        (*proc_data)[i].start_time = 0;
+        (*proc_data)[i].cgroup = -1;
+        (*proc_data)[i].last_cpu = -1;
+        (*proc_data)[i].sched_wait = -1.0f;
+        (*proc_data)[i].migrations = -1;
     }
 }
 
-int get_proc_data(ProcData **proc_data) {
-
-    // Get the number of processes on the system
-    int num_procs = get_num_procs();
-
-    // Allocate proc data array
-    *proc_data = (ProcData *) malloc(num_procs * sizeof(ProcData));
+// Reads /proc/<pid>/status and /proc/<pid>/stat into proc.
+// Returns 0 on success, 1 if the process exited before it could be read
+// and -1 on error.
+static int read_proc_entry(const char *pid_name, ProcData *proc) {
+    char status_dir[FILENAME_MAX];
+    if (snprintf(status_dir, sizeof(status_dir), "%s/%s/status", proc_root, pid_name) < 0) {
+        perror("snprintf");
+        return -1;
+    }
 
-    init_procdata(proc_data, num_procs);
+    FILE *status = fopen(status_dir, "r");
+    if (status == NULL) {
+        if (errno == ENOENT || errno == ESRCH) {
+            return 1;
+        }
+        perror("fopen");
+        return -1;
+    }
 
-    DIR *dir = opendir("/proc");
-    struct dirent *dir_entry;
+    char line[1024];
+    char data[256];
 
-    int i = 0;
-    while ((dir_entry = readdir(dir)) != NULL) {
+    // Get the desired proc data
+    while (fgets(line, sizeof(line), status) != NULL) {
 
-        if (is_integer(dir_entry->d_name)) {
+        if (strncmp(line, "Pid:", 4) == 0) {
 
-            char status_dir[FILENAME_MAX];
-            if (snprintf(status_dir, sizeof(status_dir), "/proc/%s/status", dir_entry->d_name) < 0) {
-                perror("snprintf");
+            if (sscanf(line, "Pid:%255[^\n]", data) == EOF) {
+                perror("sscanf");
+                fclose(status);
                 return -1;
             }
 
-            FILE *status = fopen(status_dir, "r");
-            if (status == NULL) {
-                perror("fopen");
-                return -1;
+            char *pid = data;
+            while (is_whitespace(pid)) {
+                pid++;
             }
-
-            char line[512];
-            char data[256];
-            
-            // Get the desired proc data
-            while (fgets(line, sizeof(line), status) != NULL) {
-
-                if (strncmp(line, "Pid:", 4) == 0) {
-
-                    if (sscanf(line, "Pid:%255[^\n]", data) == EOF) {
-                        perror("sscanf");
-                        return -1;
-                    }
-
-                    char *pid = data;
-                    while (is_whitespace(pid)) {
-                        pid++;
-                    }
-                    if (((*proc_data)[i].pid = atol(pid)) == 0) {
-                        perror("atol");
-                        return -1;
-                    }
-
-                } else if (strncmp(line, "State:", 6) == 0) {
-                    if (sscanf(line, "State:%255[^\n]", data) == EOF) {
-                        perror("sscanf");
-                        return -1;
-                    }
-                    char *state = data;
-                    while (is_whitespace(state)) {
-                        state++;
-                    }
-                    strncpy((*proc_data)[i].state, state, sizeof((*proc_data)[i].state));
-                } else if (strncmp(line, "VmRSS:", 6) == 0) {
-                    if (sscanf(line, "VmRSS:%255[^\n]", data) == EOF) {
-                        perror("sscanf");
-                        return -1;
-                    }
-                    char *memory = data;
-                    while (is_whitespace(memory)) {
-                        memory++;
-                    }
-                    (*proc_data)[i].memory_size = atol(memory);
-                } else if (strncmp(line, "Name:", 5) == 0) {
-                    if (sscanf(line, "Name:%255[^\n]", data) == EOF) {
-                        perror("sscanf");
-                        return -1;
-                    }
-                    char *name = data;
-                    while (is_whitespace(name)) {
-                        name++;
-                    }
-                    strncpy((*proc_data)[i].name, name, sizeof((*proc_data)[i].name));
-                }
+            if ((proc->pid = atol(pid)) == 0) {
+                perror("atol");
+                fclose(status);
+                return -1;
             }
 
-            char stat_dir[FILENAME_MAX];
-            if (snprintf(stat_dir, sizeof(stat_dir), "/proc/%s/stat", dir_entry->d_name) < 0) {
-                perror("snprintf");
+        } else if (strncmp(line, "State:", 6) == 0) {
+            if (sscanf(line, "State:%255[^\n]", data) == EOF) {
+                perror("sscanf");
+                fclose(status);
                 return -1;
             }
-
-            FILE *stat = fopen(stat_dir, "r");
-            if (stat == NULL) {
-                perror("fopen");
+            char *state = data;
+            while (is_whitespace(state)) {
+                state++;
+            }
+            strncpy(proc->state, state, sizeof(proc->state));
+        } else if (strncmp(line, "VmRSS:", 6) == 0) {
+            if (sscanf(line, "VmRSS:%255[^\n]", data) == EOF) {
+                perror("sscanf");
+                fclose(status);
                 return -1;
             }
-            if (fgets(line, sizeof(line), stat) != NULL) {
-                if (sscanf(line, "%*d %*s %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %ld %ld %*d %*d %d %d",
-                        &(*proc_data)[i].cpu_time, &(*proc_data)[i].sys_time, &(*proc_data)[i].priority, &(*proc_data)[i].nice) == -1) {
-                            perror("sscanf");
-                            return -1;
-                        }
+            char *memory = data;
+            while (is_whitespace(memory)) {
+                memory++;
             }
-            if (fclose(stat) == EOF) {
-                perror("fclose");
+            proc->memory_size = atol(memory);
+        } else if (strncmp(line, "Name:", 5) == 0) {
+            if (sscanf(line, "Name:%255[^\n]", data) == EOF) {
+                perror("sscanf");
+                fclose(status);
                 return -1;
             }
-            if (fclose(status) == EOF) {
-                perror("fclose");
+            char *name = data;
+            while (is_whitespace(name)) {
+                name++;
+            }
+            strncpy(proc->name, name, sizeof(proc->name));
+        }
+    }
+    if (fclose(status) == EOF) {
+        perror("fclose");
+        return -1;
+    }
+
+    char stat_dir[FILENAME_MAX];
+    if (snprintf(stat_dir, sizeof(stat_dir), "%s/%s/stat", proc_root, pid_name) < 0) {
+        perror("snprintf");
+        return -1;
+    }
+
+    FILE *stat = fopen(stat_dir, "r");
+    if (stat == NULL) {
+        if (errno == ENOENT || errno == ESRCH) {
+            return 1;
+        }
+        perror("fopen");
+        return -1;
+    }
+    if (fgets(line, sizeof(line), stat) != NULL) {
+        // comm is wrapped in parentheses and may itself contain spaces or
+        // ')', so the fixed fields are parsed from after the last ')'
+        char *fields = strrchr(line, ')');
+        if (fields != NULL && fields[1] == ' ' &&
+            sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %ld %ld %*d %*d %d %d %*d %*d %llu"
+                               " %*u %*d %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*u %*d %d",
+                   &proc->cpu_time, &proc->sys_time, &proc->priority, &proc->nice,
+                   &proc->start_time, &proc->last_cpu) == -1) {
+            perror("sscanf");
+            fclose(stat);
+            return -1;
+        }
+    }
+    if (fclose(stat) == EOF) {
+        perror("fclose");
+        return -1;
+    }
+
+    return 0;
+}
+
+int get_proc_start_time(long pid, unsigned long long *start_time) {
+    char path[FILENAME_MAX];
+    if (snprintf(path, sizeof(path), "%s/%ld/stat", proc_root, pid) >= (int)sizeof(path)) {
+        return -1;
+    }
+
+    char line[1024];
+    if (read_proc_file(path, line, sizeof(line)) < 0) {
+        return -1;
+    }
+
+    char *fields = strrchr(line, ')');
+    if (fields == NULL || fields[1] != ' ' ||
+        sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+               start_time) != 1) {
+        return -1;
+    }
+
+    return 0;
+}
+
+int get_proc_data(ProcData **proc_data, int capacity_hint) {
+
+    // The number of processes on the system is only a starting size;
+    // processes created during the scan grow the array
+    int num_procs = capacity_hint > 0 ? capacity_hint : get_num_procs();
+    if (num_procs < PROC_DATA_MIN_CAPACITY) {
+        num_procs = PROC_DATA_MIN_CAPACITY;
+    }
+
+    // Allocate proc data array
+    *proc_data = (ProcData *) malloc(num_procs * sizeof(ProcData));
+    if (*proc_data == NULL) {
+        perror("malloc");
+        return -1;
+    }
+
+    init_procdata(proc_data, num_procs);
+
+    DIR *dir = opendir(proc_root);
+    if (dir == NULL) {
+        perror("opendir");
+        return -1;
+    }
+    struct dirent *dir_entry;
+
+    int i = 0;
+    while ((dir_entry = readdir(dir)) != NULL) {
+
+        if (is_integer(dir_entry->d_name)) {
+            if (i == num_procs) {
+                ProcData *grown = (ProcData *) realloc(*proc_data, 2 * num_procs * sizeof(ProcData));
+                if (grown == NULL) {
+                    perror("realloc");
+                    closedir(dir);
+                    return -1;
+                }
+                *proc_data = grown;
+
+                ProcData *tail = grown + num_procs;
+                init_procdata(&tail, num_procs);
+                num_procs *= 2;
+            }
+
+            int ret = read_proc_entry(dir_entry->d_name, &(*proc_data)[i]);
+            if (ret == -1) {
+                closedir(dir);
                 return -1;
             }
-            i++;
+            if (ret == 0) {
+                i++;
+            }
         }
     }
     if (closedir(dir) == -1) {
@@ -193,4 +310,32 @@ int get_proc_data(ProcData **proc_data) {
     }
 
     return i;
-}
\ No newline at end of file
+}
+
+int get_proc_data_pids(ProcData **proc_data, const long *pids, int num_pids) {
+
+    // Allocate at least one entry so the caller can always free the array
+    *proc_data = (ProcData *) malloc((num_pids > 0 ? num_pids : 1) * sizeof(ProcData));
+    if (*proc_data == NULL) {
+        perror("malloc");
+        return -1;
+    }
+
+    init_procdata(proc_data, num_pids);
+
+    int i = 0;
+    for (int p = 0; p < num_pids; p++) {
+        char pid_name[32];
+        snprintf(pid_name, sizeof(pid_name), "%ld", pids[p]);
+
+        int ret = read_proc_entry(pid_name, &(*proc_data)[i]);
+        if (ret == -1) {
+            return -1;
+        }
+        if (ret == 0) {
+            i++;
+        }
+    }
+
+    return i;
+}
@@ -1,6 +1,8 @@
 #ifndef _PROC_DATA
 #define _PROC_DATA
 
+#include <stddef.h>
+#include <sys/types.h>
 
 typedef struct ProcData {
     char name[4096];
@@ -9,12 +11,38 @@ typedef struct ProcData {
     long pid;
     long cpu_time; // microseconds
     long sys_time; // microseconds
+    unsigned long long start_time; // clock ticks since boot
     long memory_size;
     int priority;
     int nice;
     char state[32];
+    int cgroup; // index into the CgroupSet in cgroup mode, -1 otherwise
+    int last_cpu; // CPU the process last ran on, -1 if unknown
+    float sched_wait; // run-queue wait in ms per second, -1 if not sampled
+    long migrations; // CPU migrations since the previous tick, -1 if not sampled
 } ProcData;
 
-int get_proc_data(struct ProcData **proc_data);
+// Reads every process in /proc. capacity_hint is the expected number of
+// processes, e.g. SysStats::total_tasks from the previous tick; with 0 the
+// count is read from /proc/loadavg.
+int get_proc_data(struct ProcData **proc_data, int capacity_hint);
+
+// Points every /proc reader at another directory laid out like /proc,
+// so tests can scan a fake process tree. NULL restores "/proc".
+void set_proc_root(const char *root);
+const char* get_proc_root(void);
+
+// Like get_proc_data(), but reads only the given PIDs instead of every
+// directory in /proc. PIDs that have already exited are skipped.
+int get_proc_data_pids(struct ProcData **proc_data, const long *pids, int num_pids);
+
+// Reads the start time of a running process, in clock ticks since boot.
+// Together with the PID it identifies a process even after the PID is reused.
+// Returns 0 on success, -1 if the process does not exist or cannot be read.
+int get_proc_start_time(long pid, unsigned long long *start_time);
+
+// Reads a whole /proc file into buf with a single read() and NUL-terminates it.
+// Returns the number of bytes read, or -1 on error.
+ssize_t read_proc_file(const char *path, char *buf, size_t size);
 
 #endif
\ No newline at end of file
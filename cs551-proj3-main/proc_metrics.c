@@ -1,32 +1,38 @@
 #include <sys/resource.h>
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include "proc_metrics.h"
+#include "pid_table.h"
+
+static void monotonic_clock(struct timeval *now) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now->tv_sec = ts.tv_sec;
+    now->tv_usec = ts.tv_nsec / 1000;
+}
+
+static MetricsClock metrics_clock = monotonic_clock;
 
 /**
- * @brief Initializes an array of CPU delta tracking structures
+ * @brief Replaces the clock used by all metrics
  *
- * @param len Number of processes to track
- * @return CPUDelta* Pointer to array of initialized CPUDelta structures, NULL if error
+ * @param clock Clock function, NULL for the monotonic clock
  */
-CPUDelta* init_cpu_deltas(int len) {
-    if (len <= 0) return NULL;
+void set_metrics_clock(MetricsClock clock) {
+    metrics_clock = clock ? clock : monotonic_clock;
+}
 
-    CPUDelta *deltas = malloc(len * sizeof(CPUDelta));
-    if (!deltas) return NULL;
-    
-    memset(deltas, 0, len * sizeof(CPUDelta));
-    
-    struct timeval current_time;
-    gettimeofday(&current_time, NULL);
-    for (int i = 0; i < len; i++) {
-        deltas[i].prev_time = current_time;
-    }
-    
-    return deltas;
+/**
+ * @brief Reads the current metrics clock
+ *
+ * @param now Receives the current time
+ */
+void get_metrics_time(struct timeval *now) {
+    metrics_clock(now);
 }
 
 /**
@@ -43,7 +49,7 @@ float calculate_cpu_percentage(const ProcData *proc, CPUDelta *delta) {
     if (!proc || !delta) return 0.0f;
 
     struct timeval current_time;
-    if (gettimeofday(&current_time, NULL) != 0) return 0.0f;
+    get_metrics_time(&current_time);
 
     // Convert clock ticks to microseconds
     long clk_tck = sysconf(_SC_CLK_TCK);
@@ -56,13 +62,19 @@ float calculate_cpu_percentage(const ProcData *proc, CPUDelta *delta) {
     // Calculate elapsed time in microseconds
     long elapsed_us = (current_time.tv_sec - delta->prev_time.tv_sec) * 1000000 +
                      (current_time.tv_usec - delta->prev_time.tv_usec);
-    
-    if (elapsed_us <= 0) return 0.0f;
 
     // Calculate CPU time differences
     long cpu_diff = curr_cpu_us - delta->prev_cpu_time;
     long sys_diff = curr_sys_us - delta->prev_sys_time;
 
+    // Store current values for next calculation, even when no time has
+    // passed, so the next interval is not charged for older CPU time
+    delta->prev_cpu_time = curr_cpu_us;
+    delta->prev_sys_time = curr_sys_us;
+    delta->prev_time = current_time;
+
+    if (elapsed_us <= 0) return 0.0f;
+
     cpu_diff = (cpu_diff < 0) ? 0 : cpu_diff;
     sys_diff = (sys_diff < 0) ? 0 : sys_diff;
 
@@ -77,11 +89,6 @@ float calculate_cpu_percentage(const ProcData *proc, CPUDelta *delta) {
         cpu_usage /= num_cores;
     }
 
-    // Store current values for next calculation
-    delta->prev_cpu_time = curr_cpu_us;
-    delta->prev_sys_time = curr_sys_us;
-    delta->prev_time = current_time;
-
     return (cpu_usage < 0.0f) ? 0.0f : 
            (cpu_usage > 100.0f) ? 100.0f : cpu_usage;
 }
@@ -116,22 +123,17 @@ float calculate_mem_percentage(const ProcData *proc) {
  *
  * @param proc_data Array of process data structures
  * @param len Number of processes in array
- * @param deltas Array of CPU delta tracking structures
+ * @param table PID table holding CPU delta tracking structures
  */
-void update_process_metrics(ProcData *proc_data, int len, CPUDelta *deltas) {
-    if (!proc_data || !deltas || len <= 0) return;
-    
+void update_process_metrics(ProcData *proc_data, int len, PidTable *table) {
+    // An empty sample still sweeps, so every exited process is forgotten
+    if (!table || len < 0 || (len > 0 && !proc_data)) return;
+
     for (int i = 0; i < len; i++) {
-        proc_data[i].percent_cpu = calculate_cpu_percentage(&proc_data[i], &deltas[i]);
+        PidEntry *entry = pid_table_get(table, proc_data[i].pid, proc_data[i].start_time);
+        proc_data[i].percent_cpu = entry ? calculate_cpu_percentage(&proc_data[i], &entry->cpu) : 0.0f;
         proc_data[i].percent_mem = calculate_mem_percentage(&proc_data[i]);
     }
-}
 
-/**
- * @brief Frees memory allocated for CPU delta tracking structures
- *
- * @param deltas Pointer to array of CPU delta structures
- */
-void cleanup_cpu_deltas(CPUDelta *deltas) {
-    free(deltas);
-}
\ No newline at end of file
+    pid_table_sweep(table);
+}
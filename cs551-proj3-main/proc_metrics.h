@@ -18,15 +18,26 @@ typedef struct {
 } CPUDelta;
 
 /**
- * @brief Initializes an array of CPUDelta structures
+ * @brief Source of the current time for every rate calculation
  *
- * Allocates and initializes CPUDelta structures for tracking CPU usage
- * of multiple processes. Sets initial timestamps and zeroes all counters.
+ * The default is CLOCK_MONOTONIC. Tests install a fake clock so elapsed
+ * times, and therefore percentages, are exact.
+ */
+typedef void (*MetricsClock)(struct timeval *now);
+
+/**
+ * @brief Replaces the clock used by all metrics
+ *
+ * @param clock Clock function, or NULL to restore the monotonic clock
+ */
+void set_metrics_clock(MetricsClock clock);
+
+/**
+ * @brief Reads the current metrics clock
  *
- * @param len Number of processes to track (size of the array to allocate)
- * @return Pointer to allocated CPUDelta array, or NULL if allocation fails
+ * @param now Receives the current time
  */
-CPUDelta* init_cpu_deltas(int len);
+void get_metrics_time(struct timeval *now);
 
 /**
  * @brief Calculates CPU usage percentage for a single process
@@ -53,27 +64,22 @@ float calculate_cpu_percentage(const ProcData *proc, CPUDelta *delta);
  */
 float calculate_mem_percentage(const ProcData *proc);
 
+struct PidTable;
+
 /**
  * @brief Updates CPU and memory metrics for all processes
  *
  * Processes an array of ProcData structures, calculating and updating
- * CPU and memory percentages for each process. This is the main function
- * that should be called periodically to refresh process metrics.
+ * CPU and memory percentages for each process. Previous CPU measurements
+ * are looked up by PID in the table, so the array may be in any order and
+ * may grow or shrink between calls. Entries of processes that are no
+ * longer in the array are swept from the table afterwards. This is the
+ * main function that should be called once per refresh tick.
  *
  * @param proc_data Array of ProcData structures to update
  * @param len Number of processes in the array
- * @param deltas Array of CPUDelta structures (one per process)
- */
-void update_process_metrics(ProcData *proc_data, int len, CPUDelta *deltas);
-
-/**
- * @brief Frees memory allocated for CPU deltas
- *
- * Properly cleans up the memory allocated by init_cpu_deltas.
- * Should be called when the CPU deltas are no longer needed.
- *
- * @param deltas Pointer to CPUDelta array to be freed
+ * @param table PID table holding per-process CPU deltas
  */
-void cleanup_cpu_deltas(CPUDelta *deltas);
+void update_process_metrics(ProcData *proc_data, int len, struct PidTable *table);
 
 #endif /* PROC_METRICS_H */
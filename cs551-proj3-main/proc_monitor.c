@@ -4,8 +4,23 @@
 #include <signal.h>
 #include "proc_data.h"
 #include "proc_metrics.h"
+#include "pid_table.h"
+#include "sys_stats.h"
+#include "alerts.h"
+#include "cgroup.h"
 #include "display.h"
 
+static const char *alert_rules_path = NULL;
+static const char *cgroup_path = NULL;
+
+void proc_monitor_set_alert_rules(const char *rules_path) {
+    alert_rules_path = rules_path;
+}
+
+void proc_monitor_set_cgroup(const char *path) {
+    cgroup_path = path;
+}
+
 void sigint_handler(int sig) {
 
     cleanup_display();
@@ -13,28 +28,66 @@ void sigint_handler(int sig) {
 }
 
 int proc_monitor(int num_procs_display, int interval) {
-    ProcData *proc_data;
+    ProcData *proc_data = NULL;
+    PidTable *table = NULL;
+    SysStats *sys_stats = NULL;
+    AlertEngine *alerts = NULL;
+    CgroupSet *cgroups = NULL;
     int num_procs;
+    int status = EXIT_FAILURE;
 
     signal(SIGINT, sigint_handler);
 
+    if (cgroup_path != NULL) {
+        cgroups = init_cgroups(NULL, cgroup_path);
+        if (cgroups == NULL) {
+            fprintf(stderr, "Error initializing cgroup monitoring.\n");
+            goto cleanup;
+        }
+    }
+
     // Retrieve process data
-    num_procs = get_proc_data(&proc_data);
+    num_procs = cgroups ? get_cgroup_proc_data(cgroups, &proc_data, 0) : get_proc_data(&proc_data, 0);
     if (num_procs < 0) {
         fprintf(stderr, "Error retrieving process data.\n");
-        return EXIT_FAILURE;
+        goto cleanup;
     }
 
-    // Initialize CPU deltas
-    CPUDelta *deltas = init_cpu_deltas(num_procs);
-    if (deltas == NULL) {
-        fprintf(stderr, "Error initializing CPU deltas.\n");
-        free(proc_data);
-        return EXIT_FAILURE;
+    // Initialize the PID table and give every process a CPU baseline
+    table = init_pid_table(num_procs);
+    if (table == NULL) {
+        fprintf(stderr, "Error initializing PID table.\n");
+        goto cleanup;
     }
+    update_process_metrics(proc_data, num_procs, table);
+    apply_cgroup_limits(cgroups, proc_data, num_procs);
 
-    // Start refreshing the display every "interval" seconds
-    refresh_display(proc_data, num_procs, deltas, interval, num_procs_display);
+    // Prime the system-wide counters so the first refresh has a baseline
+    sys_stats = init_sys_stats();
+    if (sys_stats == NULL || update_sys_stats(sys_stats) == -1) {
+        fprintf(stderr, "Error initializing system statistics.\n");
+        goto cleanup;
+    }
+
+    if (alert_rules_path != NULL) {
+        alerts = compile_alert_rules(alert_rules_path, interval);
+        if (alerts == NULL) {
+            fprintf(stderr, "Error compiling alert rules.\n");
+            goto cleanup;
+        }
+    }
 
-    return EXIT_SUCCESS;
-}
\ No newline at end of file
+    // Run the interactive display until the user quits; it takes ownership of proc_data
+    refresh_display(proc_data, num_procs, table, sys_stats, alerts, cgroups, interval, num_procs_display);
+    proc_data = NULL;
+    status = EXIT_SUCCESS;
+
+cleanup:
+    cleanup_alert_rules(alerts);
+    cleanup_sys_stats(sys_stats);
+    cleanup_pid_table(table);
+    cleanup_cgroups(cgroups);
+    free(proc_data);
+
+    return status;
+}
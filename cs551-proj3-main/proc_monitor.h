@@ -3,4 +3,15 @@
 
 int proc_monitor(int num_procs_display, int interval);
 
+// Evaluate the alert rules in the given file every refresh tick.
+// Must be called before proc_monitor(); see alerts.h for the rule syntax.
+void proc_monitor_set_alert_rules(const char *rules_path);
+
+// Monitor in cgroup v2 mode. %CPU and %MEM become relative to each
+// process's cgroup limits and the busiest cgroups are listed. "/" covers
+// the whole hierarchy; any other path, relative to the cgroup2 mount,
+// scans only the processes inside that subtree.
+// Must be called before proc_monitor().
+void proc_monitor_set_cgroup(const char *path);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include "proc_metrics.h"
+#include "sched_stats.h"
+
+// /proc/<pid>/task/<tid>/sched is about 2 KB; se.nr_migrations sits near the top
+#define SCHED_BUF_SIZE 4096
+#define SCHEDSTAT_BUF_SIZE 128
+
+typedef int (*ThreadCounter)(char *buf, unsigned long long *value);
+
+/**
+ * @brief Parses "<on-cpu ns> <run-queue wait ns> <timeslices>"
+ */
+static int parse_run_delay(char *buf, unsigned long long *run_delay) {
+    char *p = buf, *end;
+    strtoull(p, &p, 10);
+    *run_delay = strtoull(p, &end, 10);
+    return end == p ? -1 : 0;
+}
+
+static int parse_migrations(char *buf, unsigned long long *migrations) {
+    char *line = strstr(buf, "\nse.nr_migrations");
+    if (!line) return -1;
+    char *colon = strchr(line, ':');
+    if (!colon) return -1;
+
+    *migrations = strtoull(colon + 1, NULL, 10);
+    return 0;
+}
+
+/**
+ * @brief Sums a per-thread counter over every thread of a process
+ *
+ * @return Number of threads read, -1 if none could be read
+ */
+static int sum_threads(long pid, const char *name, size_t buf_size, ThreadCounter parse,
+                       unsigned long long *total) {
+    char path[FILENAME_MAX];
+    if (snprintf(path, sizeof(path), "%s/%ld/task", get_proc_root(), pid) >= (int)sizeof(path)) {
+        return -1;
+    }
+
+    DIR *dir = opendir(path);
+    if (!dir) return -1;
+
+    char buf[SCHED_BUF_SIZE];
+    if (buf_size > sizeof(buf)) buf_size = sizeof(buf);
+
+    int found = 0;
+    *total = 0;
+    struct dirent *dir_entry;
+    while ((dir_entry = readdir(dir)) != NULL) {
+        if (dir_entry->d_name[0] < '0' || dir_entry->d_name[0] > '9') continue;
+
+        char file[FILENAME_MAX];
+        if (snprintf(file, sizeof(file), "%s/%s/%s", path, dir_entry->d_name, name) >= (int)sizeof(file)) {
+            continue;
+        }
+
+        // A thread can exit between readdir() and the read
+        unsigned long long value;
+        if (read_proc_file(file, buf, buf_size) >= 0 && parse(buf, &value) == 0) {
+            *total += value;
+            found++;
+        }
+    }
+    closedir(dir);
+
+    return found ? found : -1;
+}
+
+static long elapsed_since(const struct timeval *then, const struct timeval *now) {
+    return (now->tv_sec - then->tv_sec) * 1000000L + (now->tv_usec - then->tv_usec);
+}
+
+/**
+ * @brief Updates the run-queue wait rate for one process
+ *
+ * @param proc Process to update
+ * @param table PID table holding the previous reading
+ */
+void update_sched_wait(ProcData *proc, PidTable *table) {
+    PidEntry *entry = pid_table_find(table, proc->pid);
+    if (!entry) return;
+
+    unsigned long long run_delay;
+    int threads = sum_threads(proc->pid, "schedstat", SCHEDSTAT_BUF_SIZE, parse_run_delay, &run_delay);
+    if (threads == -1) {
+        entry->wait_tick = 0;
+        return;
+    }
+
+    struct timeval now;
+    get_metrics_time(&now);
+
+    // The sweep at the end of update_process_metrics() advanced the tick,
+    // so a reading from the previous sample carries tick - 1. A thread that
+    // exited took its counter out of the sum, which can hide behind the
+    // other threads' growth, so fewer threads also means a new baseline.
+    if (entry->wait_tick == table->tick - 1 && threads >= entry->wait_threads &&
+        run_delay >= entry->prev_run_delay) {
+        long elapsed_us = elapsed_since(&entry->wait_time, &now);
+
+        // Nanoseconds of waiting per microsecond elapsed is milliseconds per second
+        if (elapsed_us > 0) {
+            proc->sched_wait = (float)(run_delay - entry->prev_run_delay) / (float)elapsed_us;
+        }
+    }
+
+    entry->prev_run_delay = run_delay;
+    entry->wait_threads = threads;
+    entry->wait_tick = table->tick;
+    entry->wait_time = now;
+}
+
+/**
+ * @brief Updates the per-tick migration count for one process
+ *
+ * @param proc Process to update
+ * @param table PID table holding the previous reading
+ */
+void update_sched_migrations(ProcData *proc, PidTable *table) {
+    PidEntry *entry = pid_table_find(table, proc->pid);
+    if (!entry) return;
+
+    unsigned long long migrations;
+    int threads = sum_threads(proc->pid, "sched", SCHED_BUF_SIZE, parse_migrations, &migrations);
+    if (threads == -1) {
+        entry->migrations_tick = 0;
+        return;
+    }
+
+    if (entry->migrations_tick == table->tick - 1 && threads >= entry->migrations_threads &&
+        migrations >= entry->prev_migrations) {
+        proc->migrations = (long)(migrations - entry->prev_migrations);
+    }
+
+    entry->prev_migrations = migrations;
+    entry->migrations_threads = threads;
+    entry->migrations_tick = table->tick;
+}
@@ -0,0 +1,46 @@
+#ifndef SCHED_STATS_H
+#define SCHED_STATS_H
+
+#include "proc_data.h"
+#include "pid_table.h"
+
+/*
+ * Scheduler counters are kept per thread, so both readers sum them over
+ * /proc/<pid>/task/<tid>/. That costs an extra directory scan and one file
+ * per thread, so they are meant for the rows that are about to be shown
+ * or sorted on, not for the whole scan.
+ *
+ * A delta needs a reading from the previous tick. A process read for the
+ * first time, or not read during the previous tick, only records a
+ * baseline and keeps its field at -1. The same happens when fewer threads
+ * are read than on the previous tick, since an exited thread takes its
+ * counter out of the sum. A thread that exits while another starts within
+ * the same tick goes unnoticed. Counters the kernel does not provide (no
+ * CONFIG_SCHEDSTATS or CONFIG_SCHED_DEBUG) also stay at -1.
+ *
+ * Both must be called after update_process_metrics() for the same sample,
+ * and at most once per process per tick.
+ */
+
+/**
+ * @brief Updates ProcData::sched_wait, the run-queue wait in ms per second
+ *
+ * Sums the second field (run_delay, ns) of every thread's schedstat file.
+ *
+ * @param proc Process to update
+ * @param table PID table the sample was last updated with
+ */
+void update_sched_wait(ProcData *proc, PidTable *table);
+
+/**
+ * @brief Updates ProcData::migrations, the CPU migrations since the previous tick
+ *
+ * Sums se.nr_migrations from every thread's sched file. These are debug
+ * files of about 2 KB each, so only call this for rows on screen.
+ *
+ * @param proc Process to update
+ * @param table PID table the sample was last updated with
+ */
+void update_sched_migrations(ProcData *proc, PidTable *table);
+
+#endif /* SCHED_STATS_H */
@@ -0,0 +1,264 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "proc_data.h"
+#include "sys_stats.h"
+
+// Per-core lines precede the long intr line in /proc/stat, so this is
+// enough for several hundred cores even when the tail gets cut off
+#define STAT_BUF_SIZE (128 * 1024)
+#define MEMINFO_BUF_SIZE (8 * 1024)
+#define LOADAVG_BUF_SIZE 256
+
+static char stat_buf[STAT_BUF_SIZE];
+
+/**
+ * @brief Maps a /proc/meminfo key to the SysStats field that receives it
+ */
+typedef struct {
+    const char *key;
+    size_t key_len;
+    size_t offset;
+} MeminfoField;
+
+#define MEMINFO_FIELD(key, member) { key ":", sizeof(key ":") - 1, offsetof(SysStats, member) }
+
+static const MeminfoField meminfo_fields[] = {
+    MEMINFO_FIELD("MemTotal", mem_total),
+    MEMINFO_FIELD("MemFree", mem_free),
+    MEMINFO_FIELD("MemAvailable", mem_available),
+    MEMINFO_FIELD("Buffers", buffers),
+    MEMINFO_FIELD("Cached", cached),
+    MEMINFO_FIELD("SwapTotal", swap_total),
+    MEMINFO_FIELD("SwapFree", swap_free),
+};
+
+#define NUM_MEMINFO_FIELDS (sizeof(meminfo_fields) / sizeof(meminfo_fields[0]))
+
+/**
+ * @brief Allocates a zeroed SysStats structure
+ *
+ * @return SysStats* Pointer to the new structure, NULL if error
+ */
+SysStats* init_sys_stats(void) {
+    SysStats *stats = malloc(sizeof(SysStats));
+    if (!stats) return NULL;
+
+    memset(stats, 0, sizeof(SysStats));
+    return stats;
+}
+
+static int read_stats_file(const char *name, char *buf, size_t size) {
+    char path[FILENAME_MAX];
+    snprintf(path, sizeof(path), "%s/%s", get_proc_root(), name);
+    return read_proc_file(path, buf, size) < 0 ? -1 : 0;
+}
+
+static char* next_line(char *p) {
+    char *nl = strchr(p, '\n');
+    return nl ? nl + 1 : p + strlen(p);
+}
+
+static void parse_cpu_times(char *p, CPUTimes *times) {
+    times->user = strtoull(p, &p, 10);
+    times->nice = strtoull(p, &p, 10);
+    times->system = strtoull(p, &p, 10);
+    times->idle = strtoull(p, &p, 10);
+    times->iowait = strtoull(p, &p, 10);
+    times->irq = strtoull(p, &p, 10);
+    times->softirq = strtoull(p, &p, 10);
+    times->steal = strtoull(p, &p, 10);
+}
+
+static unsigned long long counter_diff(unsigned long long curr, unsigned long long prev) {
+    return curr > prev ? curr - prev : 0;
+}
+
+/**
+ * @brief Converts two counter snapshots into interval utilization
+ *
+ * Guest time is already folded into user time by the kernel, so only the
+ * first eight fields take part in the total.
+ */
+static void compute_usage(const CPUTimes *prev, const CPUTimes *curr, CPUUsage *usage) {
+    unsigned long long user = counter_diff(curr->user, prev->user) + counter_diff(curr->nice, prev->nice);
+    unsigned long long sys = counter_diff(curr->system, prev->system) +
+                             counter_diff(curr->irq, prev->irq) +
+                             counter_diff(curr->softirq, prev->softirq);
+    unsigned long long idle = counter_diff(curr->idle, prev->idle);
+    unsigned long long iowait = counter_diff(curr->iowait, prev->iowait);
+    unsigned long long steal = counter_diff(curr->steal, prev->steal);
+    unsigned long long total = user + sys + idle + iowait + steal;
+
+    if (total == 0) {
+        memset(usage, 0, sizeof(CPUUsage));
+        return;
+    }
+
+    usage->user = (float)user * 100.0f / (float)total;
+    usage->sys = (float)sys * 100.0f / (float)total;
+    usage->iowait = (float)iowait * 100.0f / (float)total;
+    usage->steal = (float)steal * 100.0f / (float)total;
+    usage->busy = (float)(user + sys + steal) * 100.0f / (float)total;
+}
+
+// Far above any real machine; guards against a malformed cpuN label
+#define MAX_CPU_NUMBER 65536
+
+static int ensure_cpu_capacity(SysStats *stats, int needed) {
+    if (needed <= stats->cpu_capacity) return 0;
+
+    int capacity = stats->cpu_capacity ? stats->cpu_capacity : 8;
+    while (capacity < needed) capacity *= 2;
+
+    CPUTimes *cores = realloc(stats->cores, capacity * sizeof(CPUTimes));
+    if (!cores) return -1;
+    stats->cores = cores;
+
+    CPUUsage *usage = realloc(stats->core_usage, capacity * sizeof(CPUUsage));
+    if (!usage) return -1;
+    stats->core_usage = usage;
+
+    unsigned int *seen = realloc(stats->core_seen, capacity * sizeof(unsigned int));
+    if (!seen) return -1;
+    stats->core_seen = seen;
+
+    // CPUs that have never had a line count as offline
+    int old = stats->cpu_capacity;
+    memset(cores + old, 0, (capacity - old) * sizeof(CPUTimes));
+    memset(usage + old, 0, (capacity - old) * sizeof(CPUUsage));
+    memset(seen + old, 0, (capacity - old) * sizeof(unsigned int));
+
+    stats->cpu_capacity = capacity;
+    return 0;
+}
+
+static int parse_stat(SysStats *stats) {
+    if (read_stats_file("stat", stat_buf, sizeof(stat_buf)) == -1) return -1;
+
+    char *p = stat_buf;
+    if (strncmp(p, "cpu ", 4) != 0) return -1;
+
+    // The very first read has nothing to diff against
+    unsigned int prev_read = stats->reads;
+    unsigned int read = prev_read + 1;
+
+    CPUTimes times;
+    parse_cpu_times(p + 4, &times);
+    if (prev_read > 0) {
+        compute_usage(&stats->total, &times, &stats->total_usage);
+    }
+    stats->total = times;
+    p = next_line(p);
+
+    int online = 0;
+    while (strncmp(p, "cpu", 3) == 0) {
+        // Offline CPUs have no line, so the N in "cpuN" is the index rather
+        // than the line's position
+        char *fields;
+        long cpu = strtol(p + 3, &fields, 10);
+        if (fields == p + 3 || cpu < 0 || cpu >= MAX_CPU_NUMBER) return -1;
+        if (ensure_cpu_capacity(stats, (int)cpu + 1) == -1) return -1;
+        parse_cpu_times(fields, &times);
+
+        // A CPU coming back online starts over instead of diffing against
+        // counters from before it went offline
+        if (prev_read > 0 && stats->core_seen[cpu] == prev_read) {
+            compute_usage(&stats->cores[cpu], &times, &stats->core_usage[cpu]);
+        } else {
+            memset(&stats->core_usage[cpu], 0, sizeof(CPUUsage));
+        }
+        stats->cores[cpu] = times;
+        stats->core_seen[cpu] = read;
+        if (cpu >= stats->num_cpus) stats->num_cpus = (int)cpu + 1;
+        online++;
+        p = next_line(p);
+    }
+
+    for (int cpu = 0; cpu < stats->num_cpus; cpu++) {
+        if (stats->core_seen[cpu] != read) {
+            memset(&stats->core_usage[cpu], 0, sizeof(CPUUsage));
+        }
+    }
+    stats->num_online = online;
+    stats->reads = read;
+
+    return 0;
+}
+
+static int parse_meminfo(SysStats *stats) {
+    char buf[MEMINFO_BUF_SIZE];
+    if (read_stats_file("meminfo", buf, sizeof(buf)) == -1) return -1;
+
+    size_t found = 0;
+    for (char *p = buf; *p != '\0' && found < NUM_MEMINFO_FIELDS; p = next_line(p)) {
+        for (size_t f = 0; f < NUM_MEMINFO_FIELDS; f++) {
+            if (strncmp(p, meminfo_fields[f].key, meminfo_fields[f].key_len) == 0) {
+                unsigned long *field = (unsigned long *)((char *)stats + meminfo_fields[f].offset);
+                *field = strtoul(p + meminfo_fields[f].key_len, NULL, 10);
+                found++;
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int parse_loadavg(SysStats *stats) {
+    char buf[LOADAVG_BUF_SIZE];
+    if (read_stats_file("loadavg", buf, sizeof(buf)) == -1) return -1;
+
+    char *p = buf;
+    for (int i = 0; i < 3; i++) {
+        stats->load[i] = strtod(p, &p);
+    }
+    stats->running_tasks = (int)strtol(p, &p, 10);
+    if (*p == '/') {
+        stats->total_tasks = (int)strtol(p + 1, &p, 10);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Refreshes system-wide CPU, memory and load statistics
+ *
+ * @param stats Pointer to the statistics structure to update
+ * @return int 0 on success, -1 if error
+ */
+int update_sys_stats(SysStats *stats) {
+    if (!stats) return -1;
+
+    if (parse_stat(stats) == -1) return -1;
+    if (parse_meminfo(stats) == -1) return -1;
+    if (parse_loadavg(stats) == -1) return -1;
+
+    return 0;
+}
+
+/**
+ * @brief Tells whether a CPU had a line in the last read of /proc/stat
+ *
+ * @param stats Pointer to the statistics structure
+ * @param cpu CPU number
+ * @return int 1 if online, 0 otherwise
+ */
+int sys_stats_cpu_online(const SysStats *stats, int cpu) {
+    return cpu >= 0 && cpu < stats->num_cpus && stats->core_seen[cpu] == stats->reads;
+}
+
+/**
+ * @brief Frees memory allocated for system statistics
+ *
+ * @param stats Pointer to the statistics structure
+ */
+void cleanup_sys_stats(SysStats *stats) {
+    if (!stats) return;
+
+    free(stats->cores);
+    free(stats->core_usage);
+    free(stats->core_seen);
+    free(stats);
+}
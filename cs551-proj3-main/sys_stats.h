@@ -0,0 +1,100 @@
+#ifndef SYS_STATS_H
+#define SYS_STATS_H
+
+/**
+ * @struct CPUTimes
+ * @brief Raw cumulative jiffy counters for one line of /proc/stat
+ */
+typedef struct {
+    unsigned long long user;    /**< Time in user mode */
+    unsigned long long nice;    /**< Time in user mode with low priority */
+    unsigned long long system;  /**< Time in kernel mode */
+    unsigned long long idle;    /**< Idle time */
+    unsigned long long iowait;  /**< Idle time waiting for I/O */
+    unsigned long long irq;     /**< Time servicing hardware interrupts */
+    unsigned long long softirq; /**< Time servicing softirqs */
+    unsigned long long steal;   /**< Time stolen by the hypervisor */
+} CPUTimes;
+
+/**
+ * @struct CPUUsage
+ * @brief Utilization of one CPU over the last interval, in percent
+ */
+typedef struct {
+    float user;   /**< user + nice */
+    float sys;    /**< system + irq + softirq */
+    float iowait; /**< I/O wait */
+    float steal;  /**< Hypervisor steal */
+    float busy;   /**< Everything except idle and iowait */
+} CPUUsage;
+
+/**
+ * @struct SysStats
+ * @brief Whole-system CPU, memory and load figures for one refresh tick
+ *
+ * CPU figures are deltas between the two most recent calls to
+ * update_sys_stats(); the first call only primes the counters.
+ * Memory figures are in kilobytes, as reported by /proc/meminfo.
+ */
+typedef struct {
+    int num_cpus;            /**< Highest CPU number seen plus one; per-core arrays are indexed by it */
+    int num_online;          /**< Number of per-core lines in the last read */
+    int cpu_capacity;        /**< Allocated length of the per-core arrays */
+    unsigned int reads;      /**< Number of successful /proc/stat reads */
+    unsigned int *core_seen; /**< Read in which each core last had a line, see sys_stats_cpu_online() */
+    CPUTimes total;          /**< Aggregate "cpu" counters from the last read */
+    CPUUsage total_usage;    /**< Aggregate utilization over the last interval */
+    CPUTimes *cores;         /**< Per-core counters from the last read */
+    CPUUsage *core_usage;    /**< Per-core utilization over the last interval, zero when offline */
+
+    unsigned long mem_total;     /**< MemTotal */
+    unsigned long mem_free;      /**< MemFree */
+    unsigned long mem_available; /**< MemAvailable */
+    unsigned long buffers;       /**< Buffers */
+    unsigned long cached;        /**< Cached */
+    unsigned long swap_total;    /**< SwapTotal */
+    unsigned long swap_free;     /**< SwapFree */
+
+    double load[3];      /**< 1, 5 and 15 minute load averages */
+    int running_tasks;   /**< Currently runnable scheduling entities */
+    int total_tasks;     /**< Total scheduling entities */
+} SysStats;
+
+/**
+ * @brief Allocates a zeroed SysStats structure
+ *
+ * @return Pointer to the new structure, or NULL if allocation fails
+ */
+SysStats* init_sys_stats(void);
+
+/**
+ * @brief Refreshes system-wide statistics
+ *
+ * Reads /proc/stat, /proc/meminfo and /proc/loadavg exactly once each and
+ * recomputes per-core utilization from the difference against the previous
+ * call. Should be called once per refresh tick.
+ *
+ * @param stats Structure returned by init_sys_stats()
+ * @return 0 on success, -1 if any of the files could not be read or parsed
+ */
+int update_sys_stats(SysStats *stats);
+
+/**
+ * @brief Tells whether a CPU was listed in the last read of /proc/stat
+ *
+ * Offline CPUs have no line at all, so CPU numbers can have gaps.
+ *
+ * @param stats Structure updated by update_sys_stats()
+ * @param cpu CPU number, below num_cpus
+ * @return 1 if the CPU is online, 0 otherwise
+ */
+int sys_stats_cpu_online(const SysStats *stats, int cpu);
+
+/**
+ * @brief Frees a structure allocated by init_sys_stats()
+ *
+ * @param stats Pointer to the structure to free (may be NULL)
+ */
+void cleanup_sys_stats(SysStats *stats);
+
+#endif /* SYS_STATS_H */
@@ -1,164 +1,882 @@
+#define _XOPEN_SOURCE 700
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <malloc.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <signal.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <sys/wait.h>
 #include "proc_data.h"
 #include "proc_metrics.h"
+#include "pid_table.h"
+#include "sys_stats.h"
+#include "alerts.h"
+#include "cgroup.h"
+#include "sched_stats.h"
+#include "display.h"
+
+static int checks_run = 0;
+static int checks_failed = 0;
+
+#define CHECK(cond) do { \
+        checks_run++; \
+        if (!(cond)) { \
+            checks_failed++; \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected) do { \
+        double actual_ = (actual), expected_ = (expected); \
+        checks_run++; \
+        if (fabs(actual_ - expected_) > 0.01) { \
+            checks_failed++; \
+            fprintf(stderr, "%s:%d: CHECK_NEAR failed: %s = %f, expected %f\n", \
+                    __FILE__, __LINE__, #actual, actual_, expected_); \
+        } \
+    } while (0)
+
+// Fake monotonic clock, advanced explicitly by each test
+static struct timeval fake_now;
+
+static void fake_clock(struct timeval *now) {
+    *now = fake_now;
+}
+
+static void advance_clock(long usec) {
+    fake_now.tv_usec += usec;
+    fake_now.tv_sec += fake_now.tv_usec / 1000000;
+    fake_now.tv_usec %= 1000000;
+}
 
-// Declare functions from display.c directly
-void clear_screen();
-int compare_by_cpu(const void *a, const void *b);
-void display_top_processes(ProcData *proc_data, int len);
-void refresh_display(ProcData *proc_data, int len, CPUDelta *deltas, int interval);
+// Fake /proc tree in a temporary directory
+static char fake_root[64];
 
-// Function to print process data for testing
-void print_proc_data_for_test(ProcData *proc_data, int length) {
-    printf("PID\tName\t\tCPU%%\tMEM%%\tState\tMemory (KB)\n");
-    for (int i = 0; i < length; i++) {
-        printf("%ld\t%-10s\t%.2f\t%.2f\t%-10s\t%ld\n",
-               proc_data[i].pid, proc_data[i].name,
-               proc_data[i].percent_cpu, proc_data[i].percent_mem,
-               proc_data[i].state, proc_data[i].memory_size);
+static void write_file(const char *path, const char *content) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        exit(EXIT_FAILURE);
     }
-    printf("\n");
+    fputs(content, file);
+    fclose(file);
 }
 
-// Test for normal process data retrieval
-void test_process_data_retrieval() {
-    printf("Running Process Data Retrieval Test...\n");
-    ProcData *proc_data = NULL;
-    int proc_count = get_proc_data(&proc_data);
+static void write_fake_file(const char *rel, const char *content) {
+    char path[FILENAME_MAX];
+    snprintf(path, sizeof(path), "%s/%s", fake_root, rel);
+    write_file(path, content);
+}
 
-    if (proc_count < 0) {
-        printf("Error: get_proc_data failed with code %d\n", proc_count);
-        return;
+static void write_fake_proc(long pid, const char *name, long utime, long stime, long rss_kb,
+                            unsigned long long start_time) {
+    char path[FILENAME_MAX], content[1024];
+
+    snprintf(path, sizeof(path), "%s/%ld", fake_root, pid);
+    mkdir(path, 0755);
+
+    snprintf(path, sizeof(path), "%s/%ld/status", fake_root, pid);
+    snprintf(content, sizeof(content), "Name:\t%s\nState:\tR (running)\nPid:\t%ld\nVmRSS:\t%ld kB\n",
+             name, pid, rss_kb);
+    write_file(path, content);
+
+    snprintf(path, sizeof(path), "%s/%ld/stat", fake_root, pid);
+    snprintf(content, sizeof(content), "%ld (%s) R 1 %ld %ld 0 -1 4194304 0 0 0 0 %ld %ld 0 0 20 0 1 0 %llu 0 0 "
+             "0 0 0 0 0 0 0 0 0 0 0 0 0 17 %ld 0 0 0 0 0\n",
+             pid, name, pid, pid, utime, stime, start_time, pid % 4);
+    write_file(path, content);
+}
+
+static void remove_fake_proc(long pid) {
+    char path[FILENAME_MAX];
+    snprintf(path, sizeof(path), "%s/%ld/status", fake_root, pid);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%ld/stat", fake_root, pid);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%ld", fake_root, pid);
+    rmdir(path);
+}
+
+static int remove_entry(const char *path, const struct stat *sb, int flag, struct FTW *ftw) {
+    return remove(path);
+}
+
+static void setup_fake_tree(void) {
+    strcpy(fake_root, "/tmp/test_proc_monitor.XXXXXX");
+    if (mkdtemp(fake_root) == NULL) {
+        perror("mkdtemp");
+        exit(EXIT_FAILURE);
     }
+    write_fake_file("loadavg", "0.00 0.00 0.00 1/8 100\n");
+    set_proc_root(fake_root);
 
-    printf("Retrieved %d processes.\n", proc_count);
-    print_proc_data_for_test(proc_data, proc_count);
+    fake_now.tv_sec = 1000;
+    fake_now.tv_usec = 0;
+    set_metrics_clock(fake_clock);
+}
 
-    free(proc_data); // Free allocated memory
+static void teardown_fake_tree(void) {
+    nftw(fake_root, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+    set_proc_root(NULL);
+    set_metrics_clock(NULL);
 }
 
-// Test for CPU and Memory Percentage Calculations
-void test_cpu_memory_calculations() {
-    printf("Running CPU and Memory Calculations Test...\n");
+// Mirrors calculate_cpu_percentage(): jiffies over elapsed time, per core
+static double expected_cpu(long jiffies, long elapsed_us) {
+    long clk_tck = sysconf(_SC_CLK_TCK);
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    double percent = (double)(jiffies * 1000000 / clk_tck) * 100.0 / elapsed_us / num_cores;
+    return percent > 100.0 ? 100.0 : percent;
+}
 
+static ProcData* find_proc(ProcData *proc_data, int len, long pid) {
+    for (int i = 0; i < len; i++) {
+        if (proc_data[i].pid == pid) return &proc_data[i];
+    }
+    return NULL;
+}
+
+// Scans the fake tree and updates metrics, as one refresh tick would
+static int fake_tick(ProcData **proc_data, PidTable *table) {
+    int len = get_proc_data(proc_data, 0);
+    update_process_metrics(*proc_data, len, table);
+    return len;
+}
+
+// Test for exact %CPU between ticks
+void test_cpu_percentage_math() {
+    printf("Running CPU Percentage Math Test...\n");
+    setup_fake_tree();
+
+    PidTable *table = init_pid_table(0);
     ProcData *proc_data = NULL;
-    int proc_count = get_proc_data(&proc_data);
 
-    if (proc_count < 0) {
-        printf("Error: get_proc_data failed with code %d\n", proc_count);
-        return;
+    // First sight at the table's creation time only sets the baseline
+    write_fake_proc(100, "worker", 10, 5, 2048, 1000);
+    int len = fake_tick(&proc_data, table);
+    CHECK(len == 1);
+    CHECK_NEAR(proc_data[0].percent_cpu, 0.0);
+    free(proc_data);
+
+    // 50 user jiffies in one second
+    advance_clock(1000000);
+    write_fake_proc(100, "worker", 60, 5, 2048, 1000);
+    len = fake_tick(&proc_data, table);
+    CHECK(len == 1);
+    CHECK_NEAR(proc_data[0].percent_cpu, expected_cpu(50, 1000000));
+    free(proc_data);
+
+    // 25 user and 25 system jiffies in two and a half seconds
+    advance_clock(2500000);
+    write_fake_proc(100, "worker", 85, 30, 2048, 1000);
+    len = fake_tick(&proc_data, table);
+    CHECK_NEAR(proc_data[0].percent_cpu, expected_cpu(50, 2500000));
+    free(proc_data);
+
+    // No CPU used at all
+    advance_clock(1000000);
+    len = fake_tick(&proc_data, table);
+    CHECK_NEAR(proc_data[0].percent_cpu, 0.0);
+    free(proc_data);
+
+    cleanup_pid_table(table);
+    teardown_fake_tree();
+}
+
+// Test that a recycled PID does not inherit the previous process's CPU time
+void test_pid_reuse() {
+    printf("Running PID Reuse Test...\n");
+    setup_fake_tree();
+
+    PidTable *table = init_pid_table(0);
+    ProcData *proc_data = NULL;
+
+    write_fake_proc(200, "old", 5000, 1000, 1024, 500);
+    fake_tick(&proc_data, table);
+    free(proc_data);
+
+    // The old process exits and a new one gets the same PID with 30 jiffies
+    advance_clock(1000000);
+    write_fake_proc(200, "new", 30, 0, 1024, 900);
+    int len = fake_tick(&proc_data, table);
+    CHECK(len == 1);
+    CHECK(strcmp(proc_data[0].name, "new") == 0);
+    CHECK_NEAR(proc_data[0].percent_cpu, expected_cpu(30, 1000000));
+    free(proc_data);
+
+    PidEntry *entry = pid_table_find(table, 200);
+    CHECK(entry != NULL && entry->start_time == 900);
+
+    // Kill and renice recheck the start time before acting on a PID
+    unsigned long long start_time = 0;
+    CHECK(get_proc_start_time(200, &start_time) == 0 && start_time == 900);
+    CHECK(get_proc_start_time(201, &start_time) == -1);
+    CHECK(table->count == 1);
+
+    cleanup_pid_table(table);
+    teardown_fake_tree();
+}
+
+// Test for processes appearing and exiting between ticks
+void test_process_churn() {
+    printf("Running Process Churn Test...\n");
+    setup_fake_tree();
+
+    PidTable *table = init_pid_table(0);
+    ProcData *proc_data = NULL;
+
+    for (long pid = 1000; pid < 1050; pid++) {
+        write_fake_proc(pid, "churn", 0, 0, 100, pid);
     }
+    int len = fake_tick(&proc_data, table);
+    CHECK(len == 50);
+    CHECK(table->count == 50);
+    free(proc_data);
 
-    // Initialize CPU deltas
-    CPUDelta *cpu_deltas = init_cpu_deltas(proc_count);
-    if (!cpu_deltas) {
-        printf("Error: Failed to initialize CPU deltas.\n");
-        free(proc_data);
-        return;
+    // Half exit, and new processes born mid-interval used 10 jiffies each
+    advance_clock(1000000);
+    for (long pid = 1000; pid < 1025; pid++) {
+        remove_fake_proc(pid);
+    }
+    for (long pid = 1050; pid < 1075; pid++) {
+        write_fake_proc(pid, "churn", 10, 0, 100, pid);
     }
+    len = fake_tick(&proc_data, table);
+    CHECK(len == 50);
+    CHECK(table->count == 50);
+    CHECK(find_proc(proc_data, len, 1000) == NULL);
+    CHECK(pid_table_find(table, 1000) == NULL);
+
+    // New processes are charged only for the interval since the last tick
+    ProcData *born = find_proc(proc_data, len, 1060);
+    CHECK(born != NULL);
+    if (born) CHECK_NEAR(born->percent_cpu, expected_cpu(10, 1000000));
+    ProcData *survivor = find_proc(proc_data, len, 1030);
+    CHECK(survivor != NULL);
+    if (survivor) CHECK_NEAR(survivor->percent_cpu, 0.0);
+    free(proc_data);
 
-    // Update metrics
-    update_process_metrics(proc_data, proc_count, cpu_deltas);
+    // More processes than /proc/loadavg claims must still all be read
+    for (long pid = 2000; pid < 2300; pid++) {
+        write_fake_proc(pid, "burst", 0, 0, 100, pid);
+    }
+    len = get_proc_data(&proc_data, 0);
+    CHECK(len == 350);
+    free(proc_data);
 
-    // Print updated process data
-    printf("Updated Process Data with CPU and Memory Metrics:\n");
-    print_proc_data_for_test(proc_data, proc_count);
+    // A stale task count from the previous tick is only a starting size too
+    len = get_proc_data(&proc_data, 20);
+    CHECK(len == 350);
+    free(proc_data);
+
+    cleanup_pid_table(table);
+    teardown_fake_tree();
+}
+
+// Test for top-K ordering by every sort key
+void test_top_k_ordering() {
+    printf("Running Top-K Ordering Test...\n");
+
+    const int len = 8;
+    const float cpu[] = { 3.0f, 97.5f, 0.0f, 42.0f, 12.5f, 42.5f, 0.5f, 60.0f };
+    const long mem[] = { 700, 100, 800, 300, 50, 900, 200, 400 };
+    const char *names[] = { "sshd", "ffmpeg", "bash", "java", "cron", "postgres", "init", "nginx" };
+
+    ProcData *proc_data = calloc(len, sizeof(ProcData));
+    for (int i = 0; i < len; i++) {
+        proc_data[i].pid = 100 + (i * 37) % len;
+        proc_data[i].percent_cpu = cpu[i];
+        proc_data[i].memory_size = mem[i];
+        strcpy(proc_data[i].name, names[i]);
+    }
+
+    qsort(proc_data, len, sizeof(ProcData), compare_by_cpu);
+    const float top_cpu[] = { 97.5f, 60.0f, 42.5f };
+    for (int i = 0; i < 3; i++) {
+        CHECK(proc_data[i].percent_cpu == top_cpu[i]);
+    }
+    for (int i = 1; i < len; i++) {
+        CHECK(proc_data[i - 1].percent_cpu >= proc_data[i].percent_cpu);
+    }
+
+    qsort(proc_data, len, sizeof(ProcData), compare_by_mem);
+    CHECK(proc_data[0].memory_size == 900 && proc_data[1].memory_size == 800);
+    for (int i = 1; i < len; i++) {
+        CHECK(proc_data[i - 1].memory_size >= proc_data[i].memory_size);
+    }
+
+    qsort(proc_data, len, sizeof(ProcData), compare_by_pid);
+    for (int i = 1; i < len; i++) {
+        CHECK(proc_data[i - 1].pid < proc_data[i].pid);
+    }
+
+    qsort(proc_data, len, sizeof(ProcData), compare_by_name);
+    CHECK(strcmp(proc_data[0].name, "bash") == 0);
+    for (int i = 1; i < len; i++) {
+        CHECK(strcmp(proc_data[i - 1].name, proc_data[i].name) <= 0);
+    }
 
-    // Cleanup
-    cleanup_cpu_deltas(cpu_deltas);
     free(proc_data);
 }
 
-// Test for Top Process Display
-void test_top_process_display() {
-    printf("Running Top Process Display Test...\n");
+// Stress test: tens of thousands of PIDs come and go, memory must not grow
+void test_pid_churn_stress() {
+    printf("Running PID Churn Stress Test...\n");
+    setup_fake_tree();
+
+    const int live = 16384;
+    const int ticks = 16;
+    PidTable *table = init_pid_table(0);
+    ProcData *proc_data = calloc(live, sizeof(ProcData));
+
+    // Each tick replaces half the processes with never-seen PIDs
+    long next_pid = 1;
+    for (int i = 0; i < live; i++) {
+        proc_data[i].pid = next_pid++;
+        proc_data[i].start_time = proc_data[i].pid;
+    }
+
+    int max_capacity = 0;
+    for (int tick = 0; tick < ticks; tick++) {
+        for (int i = tick % 2; i < live; i += 2) {
+            proc_data[i].pid = next_pid++;
+            proc_data[i].start_time = proc_data[i].pid;
+            proc_data[i].cpu_time = 0;
+        }
+        for (int i = 0; i < live; i++) {
+            proc_data[i].cpu_time += 1;
+        }
+
+        advance_clock(1000000);
+        update_process_metrics(proc_data, live, table);
 
+        CHECK(table->count == live);
+        if (table->capacity > max_capacity) max_capacity = table->capacity;
+    }
+    CHECK(next_pid > 100000);
+    CHECK(max_capacity <= 4 * live);
+
+    // Everything exits; the table shrinks back
+    update_process_metrics(NULL, 0, table);
+    CHECK(table->count == 0);
+    CHECK(table->capacity <= 64);
+
+    free(proc_data);
+    cleanup_pid_table(table);
+    teardown_fake_tree();
+}
+
+// Stress test through the scanner: the process array must grow past the
+// loadavg hint, and neither the table nor the heap may grow with churn
+void test_scanner_churn_stress() {
+    printf("Running Scanner Churn Stress Test...\n");
+    setup_fake_tree();
+
+    // loadavg claims 8 processes, far fewer than the scan finds
+    const int live = 2048;
+    const int ticks = 8;
+    long live_pids[2048];
+    PidTable *table = init_pid_table(0);
     ProcData *proc_data = NULL;
-    int proc_count = get_proc_data(&proc_data);
 
-    if (proc_count < 0) {
-        printf("Error: get_proc_data failed with code %d\n", proc_count);
-        return;
+    long next_pid = 1;
+    for (int i = 0; i < live; i++) {
+        live_pids[i] = next_pid++;
+        write_fake_proc(live_pids[i], "scan", 0, 0, 100, live_pids[i]);
     }
+    int len = fake_tick(&proc_data, table);
+    CHECK(len == live);
+    free(proc_data);
+
+    size_t heap_start = 0;
+    for (int tick = 0; tick < ticks; tick++) {
+        // Half the processes exit and never-seen PIDs replace them
+        for (int i = tick % 2; i < live; i += 2) {
+            remove_fake_proc(live_pids[i]);
+            live_pids[i] = next_pid++;
+            write_fake_proc(live_pids[i], "scan", 0, 0, 100, live_pids[i]);
+        }
 
-    // Initialize CPU deltas
-    CPUDelta *cpu_deltas = init_cpu_deltas(proc_count);
-    if (!cpu_deltas) {
-        printf("Error: Failed to initialize CPU deltas.\n");
+        advance_clock(1000000);
+        len = fake_tick(&proc_data, table);
+        CHECK(len == live);
+        CHECK(table->count == live);
+        CHECK(find_proc(proc_data, len, live_pids[tick % 2]) != NULL);
         free(proc_data);
+
+        if (tick == 1) heap_start = mallinfo2().uordblks;
+    }
+    CHECK(table->capacity <= 4 * live);
+
+    // Steady churn must not leak: allow a little allocator slack
+    size_t heap_end = mallinfo2().uordblks;
+    CHECK(heap_end <= heap_start + 64 * 1024);
+
+    // A PID list with exited members returns only the live ones
+    long pids[] = { live_pids[0], 1, live_pids[1], 2, live_pids[2] };
+    len = get_proc_data_pids(&proc_data, pids, 5);
+    CHECK(len == 3);
+    free(proc_data);
+
+    cleanup_pid_table(table);
+    teardown_fake_tree();
+}
+
+// Test for system-wide per-core utilization, memory and load
+void test_system_stats() {
+    printf("Running System Statistics Test...\n");
+    setup_fake_tree();
+
+    write_fake_file("meminfo", "MemTotal: 8000000 kB\nMemFree: 1000000 kB\nMemAvailable: 6000000 kB\n"
+                               "Buffers: 100000 kB\nCached: 2000000 kB\nSwapTotal: 4000000 kB\nSwapFree: 3000000 kB\n");
+    write_fake_file("loadavg", "1.50 0.75 0.25 3/512 4242\n");
+    write_fake_file("stat", "cpu  100 0 100 800 0 0 0 0 0 0\n"
+                            "cpu0 50 0 50 400 0 0 0 0 0 0\n"
+                            "cpu1 50 0 50 400 0 0 0 0 0 0\n"
+                            "intr 0\n");
+
+    SysStats *stats = init_sys_stats();
+    CHECK(update_sys_stats(stats) == 0);
+    CHECK(stats->num_cpus == 2);
+    CHECK_NEAR(stats->total_usage.busy, 0.0);
+
+    // cpu0: 60 user, 20 nice, 10 system, 10 softirq, 80 idle, 10 iowait, 10 steal
+    // cpu1: 20 user, 10 system, 70 idle
+    write_fake_file("stat", "cpu  180 20 120 950 10 0 10 10 0 0\n"
+                            "cpu0 110 20 60 480 10 0 10 10 0 0\n"
+                            "cpu1 70 0 60 470 0 0 0 0 0 0\n"
+                            "intr 0\n");
+    CHECK(update_sys_stats(stats) == 0);
+    CHECK_NEAR(stats->core_usage[0].user, 40.0);
+    CHECK_NEAR(stats->core_usage[0].sys, 10.0);
+    CHECK_NEAR(stats->core_usage[0].iowait, 5.0);
+    CHECK_NEAR(stats->core_usage[0].steal, 5.0);
+    CHECK_NEAR(stats->core_usage[0].busy, 55.0);
+    CHECK_NEAR(stats->core_usage[1].user, 20.0);
+    CHECK_NEAR(stats->core_usage[1].sys, 10.0);
+    CHECK_NEAR(stats->core_usage[1].busy, 30.0);
+
+    // cpu1 goes offline and cpu2 appears: cores are indexed by their
+    // number, not by their line's position
+    write_fake_file("stat", "cpu  280 20 120 1050 10 0 10 10 0 0\n"
+                            "cpu0 210 20 60 480 10 0 10 10 0 0\n"
+                            "cpu2 500 0 100 400 0 0 0 0 0 0\n"
+                            "intr 0\n");
+    CHECK(update_sys_stats(stats) == 0);
+    CHECK(stats->num_cpus == 3 && stats->num_online == 2);
+    CHECK(sys_stats_cpu_online(stats, 0) && !sys_stats_cpu_online(stats, 1) && sys_stats_cpu_online(stats, 2));
+    CHECK_NEAR(stats->core_usage[0].user, 100.0);
+    CHECK_NEAR(stats->core_usage[1].busy, 0.0);
+    CHECK_NEAR(stats->core_usage[2].busy, 0.0);
+
+    // cpu1 comes back and starts over instead of diffing against old counters
+    write_fake_file("stat", "cpu  380 20 120 1150 10 0 10 10 0 0\n"
+                            "cpu0 210 20 60 580 10 0 10 10 0 0\n"
+                            "cpu1 900 0 900 900 0 0 0 0 0 0\n"
+                            "cpu2 550 0 100 450 0 0 0 0 0 0\n"
+                            "intr 0\n");
+    CHECK(update_sys_stats(stats) == 0);
+    CHECK(stats->num_online == 3 && sys_stats_cpu_online(stats, 1));
+    CHECK_NEAR(stats->core_usage[0].busy, 0.0);
+    CHECK_NEAR(stats->core_usage[1].busy, 0.0);
+    CHECK_NEAR(stats->core_usage[2].user, 50.0);
+
+    CHECK(stats->mem_total == 8000000 && stats->mem_available == 6000000);
+    CHECK(stats->swap_total == 4000000 && stats->swap_free == 3000000);
+    CHECK_NEAR(stats->load[0], 1.5);
+    CHECK(stats->running_tasks == 3 && stats->total_tasks == 512);
+
+    cleanup_sys_stats(stats);
+    teardown_fake_tree();
+}
+
+static int count_lines_containing(const char *path, const char *needle) {
+    FILE *file = fopen(path, "r");
+    if (!file) return 0;
+
+    int count = 0;
+    char line[1024];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        if (strstr(line, needle)) count++;
+    }
+    fclose(file);
+    return count;
+}
+
+// Test for alert rule hysteresis on exact tick boundaries
+void test_alert_rules() {
+    printf("Running Alert Rules Test...\n");
+    setup_fake_tree();
+
+    char rules_path[FILENAME_MAX], log_path[FILENAME_MAX], rules[3 * FILENAME_MAX];
+    snprintf(rules_path, sizeof(rules_path), "%s/rules", fake_root);
+    snprintf(log_path, sizeof(log_path), "%s/alerts.log", fake_root);
+    snprintf(rules, sizeof(rules),
+             "# growth is measured between consecutive ticks\n"
+             "rss_growth > 100MB/min for 3 -> log %s\n"
+             "rss > 1G -> log %s\n", log_path, log_path);
+    write_file(rules_path, rules);
+
+    // The expected error message goes to /dev/null instead of the test output
+    fflush(stderr);
+    int saved_stderr = dup(STDERR_FILENO);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, STDERR_FILENO);
+    CHECK(compile_alert_rules("/nonexistent/rules", 1) == NULL);
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stderr);
+    close(devnull);
+    AlertEngine *engine = compile_alert_rules(rules_path, 1);
+    CHECK(engine != NULL);
+    if (!engine) {
+        teardown_fake_tree();
         return;
     }
+    CHECK(engine->num_rules == 2);
+    CHECK(engine->rules[0].ticks == 3);
+    CHECK_NEAR(engine->rules[0].threshold, 100.0 * 1024 / 60);
+
+    // Long durations at short intervals need more than 255 ticks
+    char long_rules[FILENAME_MAX + 64];
+    snprintf(long_rules, sizeof(long_rules), "cpu > 95 for 300s -> log %s\n", log_path);
+    write_file(rules_path, long_rules);
+    AlertEngine *long_engine = compile_alert_rules(rules_path, 1);
+    CHECK(long_engine != NULL && long_engine->rules[0].ticks == 300);
+    cleanup_alert_rules(long_engine);
+
+    PidTable *table = init_pid_table(0);
+    ProcData proc;
+    memset(&proc, 0, sizeof(proc));
+    proc.pid = 4242;
+    proc.start_time = 1;
+    strcpy(proc.name, "leaky");
+    proc.memory_size = 100 * 1024;
+
+    // 2 MB/s is 120 MB/min; the first tick has no rate yet, so the rule
+    // matches on ticks 2, 3 and 4 and fires on tick 4
+    for (int tick = 1; tick <= 5; tick++) {
+        advance_clock(1000000);
+        if (tick > 1) proc.memory_size += 2048;
+        update_process_metrics(&proc, 1, table);
+        evaluate_alerts(engine, &proc, 1, table);
+        CHECK(count_lines_containing(log_path, "FIRED") == (tick >= 4 ? 1 : 0));
+    }
+
+    // Growth stops: the alert clears once and can fire again later
+    advance_clock(1000000);
+    update_process_metrics(&proc, 1, table);
+    evaluate_alerts(engine, &proc, 1, table);
+    CHECK(count_lines_containing(log_path, "CLEARED") == 1);
+    CHECK(count_lines_containing(log_path, "rss > 1G") == 0);
 
-    // Update metrics
-    update_process_metrics(proc_data, proc_count, cpu_deltas);
+    cleanup_alert_rules(engine);
+    cleanup_pid_table(table);
+    teardown_fake_tree();
+}
 
-    // Display top processes
-    display_top_processes(proc_data, proc_count);
+// Test for cgroup limits, attribution and subtree-only scanning
+void test_cgroup_limits() {
+    printf("Running Cgroup Limits Test...\n");
+    setup_fake_tree();
+
+    char path[FILENAME_MAX];
+    snprintf(path, sizeof(path), "%s/cgroup", fake_root);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/cgroup/a", fake_root);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/cgroup/a/b", fake_root);
+    mkdir(path, 0755);
+
+    write_fake_file("cgroup/cgroup.controllers", "cpu memory\n");
+    write_fake_file("cgroup/cgroup.procs", "302\n");
+    write_fake_file("cgroup/a/cgroup.procs", "");
+    write_fake_file("cgroup/a/cpu.max", "50000 100000\n");
+    write_fake_file("cgroup/a/memory.max", "1073741824\n");
+    write_fake_file("cgroup/a/b/cgroup.procs", "300\n301\n");
+    write_fake_file("cgroup/a/b/cpu.max", "max 100000\n");
+    write_fake_file("cgroup/a/b/memory.max", "max\n");
+    write_fake_file("cgroup/a/b/memory.current", "268435456\n");
+    write_fake_file("cgroup/a/b/cpu.stat", "usage_usec 1000000\nuser_usec 0\n");
+
+    write_fake_proc(300, "app", 0, 0, 262144, 1);
+    write_fake_proc(301, "sidecar", 0, 0, 1024, 2);
+    write_fake_proc(302, "outside", 0, 0, 1024, 3);
+
+    snprintf(path, sizeof(path), "%s/cgroup", fake_root);
+    CgroupSet *set = init_cgroups(path, "/a/b");
+    CHECK(set != NULL);
+    if (!set) {
+        teardown_fake_tree();
+        return;
+    }
+    CHECK(set->subtree_only);
 
-    // Cleanup
-    cleanup_cpu_deltas(cpu_deltas);
+    ProcData *proc_data = NULL;
+    int len = get_cgroup_proc_data(set, &proc_data, 0);
+    CHECK(len == 2);
+    CHECK(find_proc(proc_data, len, 302) == NULL);
+    CHECK(set->num_groups == 1);
+    CHECK_NEAR(set->groups[0].cpu_limit, 0.5);
+    CHECK(set->groups[0].memory_limit == 1073741824ULL);
+    CHECK_NEAR(set->groups[0].percent_mem, 25.0);
     free(proc_data);
-}
 
-// Function to create a large number of child processes
-void fork_child_processes(int num_children) {
-    for (int i = 0; i < num_children; i++) {
-        pid_t pid = fork();
-        if (pid == 0) {
-            // Child process: Simulate some work and exit
-            sleep(10); // Keep the child process alive for a short time
-            exit(0);
-        }
+    // A quarter of a core over one second is half of the 0.5 core quota
+    advance_clock(1000000);
+    write_fake_file("cgroup/a/b/cpu.stat", "usage_usec 1250000\nuser_usec 0\n");
+    len = get_cgroup_proc_data(set, &proc_data, 0);
+    CHECK_NEAR(set->groups[0].cpu_cores, 0.25);
+    CHECK_NEAR(set->groups[0].percent_cpu, 50.0);
+
+    // Process percentages become relative to the cgroup limits
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 0; i < len; i++) {
+        proc_data[i].percent_cpu = 10.0f / num_cores;
+    }
+    apply_cgroup_limits(set, proc_data, len);
+    ProcData *app = find_proc(proc_data, len, 300);
+    CHECK(app != NULL);
+    if (app) {
+        CHECK(app->cgroup == 0);
+        CHECK_NEAR(app->percent_cpu, 20.0);
+        CHECK_NEAR(app->percent_mem, 25.0);
     }
+    CHECK(set->groups[0].num_procs == 2);
+    free(proc_data);
+    cleanup_cgroups(set);
+
+    // The whole hierarchy attributes every process to its own cgroup
+    set = init_cgroups(path, "/");
+    len = get_cgroup_proc_data(set, &proc_data, 0);
+    apply_cgroup_limits(set, proc_data, len);
+    CHECK(len == 3);
+    CHECK(set->num_groups == 3);
+    ProcData *outside = find_proc(proc_data, len, 302);
+    CHECK(outside != NULL && strcmp(set->groups[outside->cgroup].path, "/") == 0);
+    ProcData *sidecar = find_proc(proc_data, len, 301);
+    CHECK(sidecar != NULL && strcmp(set->groups[sidecar->cgroup].path, "/a/b") == 0);
+    free(proc_data);
+    cleanup_cgroups(set);
+
+    teardown_fake_tree();
 }
 
-// Test for handling a large number of processes
-void test_large_number_of_processes() {
-    printf("Running Large Number of Processes Test...\n");
+static void write_fake_thread(long pid, long tid, unsigned long long run_delay, long migrations) {
+    char path[FILENAME_MAX], rel[64], content[512];
+
+    snprintf(path, sizeof(path), "%s/%ld/task", fake_root, pid);
+    mkdir(path, 0755);
+    snprintf(path, sizeof(path), "%s/%ld/task/%ld", fake_root, pid, tid);
+    mkdir(path, 0755);
+
+    snprintf(rel, sizeof(rel), "%ld/task/%ld/schedstat", pid, tid);
+    snprintf(content, sizeof(content), "123456 %llu 42\n", run_delay);
+    write_fake_file(rel, content);
+
+    snprintf(rel, sizeof(rel), "%ld/task/%ld/sched", pid, tid);
+    snprintf(content, sizeof(content),
+             "worker (%ld, #threads: 2)\n"
+             "-------------------------------------------------------------------\n"
+             "se.exec_start                                :         12345.678901\n"
+             "se.nr_migrations                             :                  %ld\n"
+             "nr_switches                                  :                   99\n",
+             tid, migrations);
+    write_fake_file(rel, content);
+}
 
-    int num_children = 100; // Number of child processes to fork
-    fork_child_processes(num_children);
+static void remove_fake_thread(long pid, long tid) {
+    char path[FILENAME_MAX];
 
-    // Parent process retrieves process data
+    snprintf(path, sizeof(path), "%s/%ld/task/%ld/schedstat", fake_root, pid, tid);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%ld/task/%ld/sched", fake_root, pid, tid);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s/%ld/task/%ld", fake_root, pid, tid);
+    rmdir(path);
+}
+
+static void sched_tick(ProcData *proc, PidTable *table) {
+    update_sched_wait(proc, table);
+    update_sched_migrations(proc, table);
+}
+
+// Test for run-queue wait, migrations and last CPU as per-tick deltas
+void test_sched_stats() {
+    printf("Running Scheduler Statistics Test...\n");
+    setup_fake_tree();
+
+    PidTable *table = init_pid_table(0);
     ProcData *proc_data = NULL;
-    int proc_count = get_proc_data(&proc_data);
 
-    if (proc_count < 0) {
-        printf("Error: get_proc_data failed with code %d\n", proc_count);
-        return;
+    // A sleeping main thread and a busy worker thread
+    write_fake_proc(300, "pool", 0, 0, 100, 1);
+    write_fake_proc(301, "Web Content (x)", 0, 0, 100, 2);
+    write_fake_thread(300, 300, 1000, 1);
+    write_fake_thread(300, 310, 5000000, 9);
+
+    // The first read only records a baseline
+    int len = fake_tick(&proc_data, table);
+    CHECK(len == 2);
+    ProcData *pool = find_proc(proc_data, len, 300);
+    CHECK(pool != NULL && pool->last_cpu == 0);
+    if (pool) {
+        CHECK(pool->sched_wait < 0.0f && pool->migrations == -1);
+        sched_tick(pool, table);
+        CHECK(pool->sched_wait < 0.0f && pool->migrations == -1);
+    }
+    free(proc_data);
+
+    // The worker waits 250 ms and migrates 3 times over half a second
+    advance_clock(500000);
+    write_fake_thread(300, 310, 255000000, 12);
+    len = fake_tick(&proc_data, table);
+    pool = find_proc(proc_data, len, 300);
+    CHECK(pool != NULL);
+    if (pool) {
+        sched_tick(pool, table);
+        CHECK_NEAR(pool->sched_wait, 500.0);
+        CHECK(pool->migrations == 3);
+    }
+
+    // Kernels without schedstat or sched files leave the fields unset
+    ProcData *nosched = find_proc(proc_data, len, 301);
+    // A comm with spaces and parentheses must not shift the stat fields
+    CHECK(nosched != NULL && nosched->last_cpu == 1 && nosched->start_time == 2 && nosched->priority == 20);
+    if (nosched) {
+        sched_tick(nosched, table);
+        CHECK(nosched->sched_wait < 0.0f && nosched->migrations == -1);
+    }
+    free(proc_data);
+
+    // A process skipped for a tick has no delta and starts over
+    advance_clock(1000000);
+    len = fake_tick(&proc_data, table);
+    free(proc_data);
+
+    advance_clock(1000000);
+    write_fake_thread(300, 310, 355000000, 19);
+    len = fake_tick(&proc_data, table);
+    pool = find_proc(proc_data, len, 300);
+    if (pool) {
+        sched_tick(pool, table);
+        CHECK(pool->sched_wait < 0.0f && pool->migrations == -1);
+    }
+    free(proc_data);
+
+    // A new thread joins the sum
+    advance_clock(1000000);
+    write_fake_thread(300, 311, 10000000, 0);
+    len = fake_tick(&proc_data, table);
+    pool = find_proc(proc_data, len, 300);
+    if (pool) {
+        sched_tick(pool, table);
+        CHECK_NEAR(pool->sched_wait, 10.0);
+        CHECK(pool->migrations == 0);
     }
 
-    printf("Retrieved %d processes, including %d child processes.\n", proc_count, num_children);
-    printf("Displaying first 10 processes for verification:\n");
-    for (int i = 0; i < (proc_count < 10 ? proc_count : 10); i++) {
-        printf("PID: %ld, Name: %s, State: %s, Memory: %ld KB\n",
-               proc_data[i].pid, proc_data[i].name, proc_data[i].state, proc_data[i].memory_size);
+    // Sorting by wait puts unsampled rows last
+    qsort(proc_data, len, sizeof(ProcData), compare_by_wait);
+    CHECK(proc_data[0].pid == 300);
+    free(proc_data);
+
+    // A thread exits while the other grows by more than it took with it,
+    // so the sum still rises but the tick only records a baseline
+    advance_clock(1000000);
+    remove_fake_thread(300, 311);
+    write_fake_thread(300, 310, 455000000, 24);
+    len = fake_tick(&proc_data, table);
+    pool = find_proc(proc_data, len, 300);
+    if (pool) {
+        sched_tick(pool, table);
+        CHECK(pool->sched_wait < 0.0f && pool->migrations == -1);
     }
+    free(proc_data);
 
-    // Cleanup
+    advance_clock(1000000);
+    write_fake_thread(300, 310, 475000000, 26);
+    len = fake_tick(&proc_data, table);
+    pool = find_proc(proc_data, len, 300);
+    if (pool) {
+        sched_tick(pool, table);
+        CHECK_NEAR(pool->sched_wait, 20.0);
+        CHECK(pool->migrations == 2);
+    }
     free(proc_data);
 
-    // Wait for all child processes to terminate
-    for (int i = 0; i < num_children; i++) {
-        wait(NULL); // Wait for each child process to exit
+    cleanup_pid_table(table);
+    teardown_fake_tree();
+}
+
+// Test for reading the real /proc, including freshly forked children
+void test_real_process_data() {
+    printf("Running Real Process Data Test...\n");
+
+    const int num_children = 100;
+    pid_t children[100];
+    int num_forked = 0;
+    while (num_forked < num_children) {
+        pid_t child = fork();
+        if (child == -1) {
+            perror("fork");
+            break;
+        }
+        if (child == 0) {
+            pause();
+            _exit(0);
+        }
+        children[num_forked++] = child;
+    }
+    CHECK(num_forked == num_children);
+
+    ProcData *proc_data = NULL;
+    int len = get_proc_data(&proc_data, 0);
+    CHECK(len > num_forked);
+
+    ProcData *self = find_proc(proc_data, len, getpid());
+    CHECK(self != NULL);
+    if (self) {
+        CHECK(strncmp(self->name, "test_proc_monit", 15) == 0);
+        CHECK(self->state[0] == 'R');
+        CHECK(self->start_time > 0);
+        CHECK(self->last_cpu >= 0 && self->last_cpu < sysconf(_SC_NPROCESSORS_CONF));
     }
 
-    printf("Test for large number of processes completed.\n");
+    int found = 0;
+    for (int i = 0; i < num_forked; i++) {
+        if (find_proc(proc_data, len, children[i]) != NULL) found++;
+    }
+    CHECK(found == num_forked);
+    free(proc_data);
+
+    // Only real child PIDs: kill(-1, ...) would signal every process we own
+    for (int i = 0; i < num_forked; i++) {
+        if (children[i] > 0) {
+            kill(children[i], SIGKILL);
+            waitpid(children[i], NULL, 0);
+        }
+    }
 }
 
 // Main function to run all tests
 int main() {
     printf("Starting Test Program...\n");
 
-    test_process_data_retrieval();
-    test_cpu_memory_calculations();
-    test_top_process_display();
-    test_large_number_of_processes();
-
-    printf("All tests completed.\n");
-    return 0;
+    test_cpu_percentage_math();
+    test_pid_reuse();
+    test_process_churn();
+    test_top_k_ordering();
+    test_pid_churn_stress();
+    test_scanner_churn_stress();
+    test_system_stats();
+    test_alert_rules();
+    test_cgroup_limits();
+    test_sched_stats();
+    test_real_process_data();
+
+    printf("%d checks, %d failed.\n", checks_run, checks_failed);
+    return checks_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }